@@ -0,0 +1,233 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 18 Oct 2026
+
+    Timings for the processing paths, run from the command line:
+
+        GenreGenieBenchmarks [stages|precision|state]
+
+    With no argument every benchmark runs. Only numbers from the Release
+    configuration mean anything.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int numChannels = 2;
+
+    // calls 'function' until a quarter of a second has passed, after a warm-up, and returns the mean time per call
+    template<typename Function>
+    double getNanosecondsPerCall(Function&& function)
+    {
+        for( int i = 0; i < 100; ++i )
+            function();
+
+        const auto start = juce::Time::getHighResolutionTicks();
+        const auto minimumTicks = juce::Time::secondsToHighResolutionTicks(0.25);
+
+        juce::int64 elapsed = 0;
+        int numCalls = 0;
+
+        do
+        {
+            function();
+            ++numCalls;
+            elapsed = juce::Time::getHighResolutionTicks() - start;
+        }
+        while( elapsed < minimumTicks );
+
+        return juce::Time::highResolutionTicksToSeconds(elapsed) * 1.0e9 / numCalls;
+    }
+
+    // every stage doing some real work, so none of them is skipped inside its own process()
+    ChainSettings makeBenchmarkSettings()
+    {
+        ChainSettings settings;
+        settings.lowCutFreq = 80.f;
+        settings.highCutFreq = 12000.f;
+        settings.peakFreq = 1000.f;
+        settings.peakGainInDecibels = 3.f;
+        settings.compThreshold = -18.f;
+        settings.compRatio = 4.f;
+        settings.distortionAmount = 2.f;
+        settings.delayTimeMs = 250.f;
+        settings.delayFeedback = 0.3f;
+        settings.delayMix = 0.2f;
+        settings.reverbSize = 0.5f;
+        settings.reverbDecay = 0.5f;
+        settings.reverbMix = 0.2f;
+        return settings;
+    }
+
+    /*
+     nanoseconds per sample frame for 'stages' at 'blockSize'. The chain is fed noise, and
+     settles before it's timed, so no smoothing or stage fade is included.
+     */
+    template<typename SampleType>
+    double timeChain(int blockSize, int stages, int chainOrder = 0)
+    {
+        auto chain = std::make_unique<ProcessingChain<SampleType>>();
+        chain->prepare({ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels });
+
+        auto settings = makeBenchmarkSettings();
+        settings.chainOrder = chainOrder;
+
+        auto snapshot = makeChainSnapshot(settings, sampleRate);
+        snapshot.generation = 1;
+        chain->applySnapshot(snapshot);
+
+        juce::AudioBuffer<SampleType> buffer(numChannels, blockSize);
+        juce::Random random;
+        for( int ch = 0; ch < numChannels; ++ch )
+            for( int i = 0; i < blockSize; ++i )
+                buffer.setSample(ch, i, SampleType(random.nextFloat() * 2.f - 1.f) * SampleType(0.25));
+
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+
+        // the stage switch fades in over a few blocks, so it's done before the timing starts
+        for( int i = 0; i < 64; ++i )
+            chain->process(block, stages);
+
+        return getNanosecondsPerCall([&] { chain->process(block, stages); }) / blockSize;
+    }
+
+    /*
+     the compile-time specialised path every bypass combination takes in the default order,
+     against the same stages walked through the run-time stage table, which another order uses.
+     */
+    void benchmarkStages()
+    {
+        std::cout << "Stage combinations, ns per stereo frame (specialised / table)" << std::endl;
+
+        for( auto blockSize : { 16, 32, 64, 256 } )
+        {
+            std::cout << "  block " << blockSize << std::endl;
+
+            for( int stages = 0; stages < ChainStages::NumStageCombinations; ++stages )
+            {
+                juce::String name;
+                for( int stage = ChainStages::EQStage; stage < ChainStages::NumStageCombinations; stage <<= 1 )
+                    if( (stages & stage) != 0 )
+                        name << (name.isEmpty() ? "" : "+") << getStageName(stage);
+
+                const auto specialised = timeChain<float>(blockSize, stages, 0);
+                const auto table = timeChain<float>(blockSize, stages, 1);
+
+                std::cout << "    " << (name.isEmpty() ? juce::String("(none)") : name).paddedRight(' ', 36)
+                          << juce::String(specialised, 2).paddedLeft(' ', 9) << " / "
+                          << juce::String(table, 2).paddedLeft(' ', 9) << std::endl;
+            }
+        }
+    }
+
+    /*
+     what the double chain costs over the float one, stage by stage. The reverb and the
+     linear-phase convolution only come in float, so the double chain pays for a conversion there.
+     */
+    void benchmarkPrecision()
+    {
+        std::cout << "Precision, ns per stereo frame (float / double, ratio)" << std::endl;
+
+        for( auto blockSize : { 64, 512 } )
+        {
+            std::cout << "  block " << blockSize << std::endl;
+
+            for( int stage = ChainStages::EQStage; stage < ChainStages::NumStageCombinations; stage <<= 1 )
+            {
+                const auto singlePrecision = timeChain<float>(blockSize, stage);
+                const auto doublePrecision = timeChain<double>(blockSize, stage);
+
+                std::cout << "    " << getStageName(stage).paddedRight(' ', 12)
+                          << juce::String(singlePrecision, 2).paddedLeft(' ', 9) << " / "
+                          << juce::String(doublePrecision, 2).paddedLeft(' ', 9)
+                          << juce::String(doublePrecision / singlePrecision, 2).paddedLeft(' ', 8) << "x" << std::endl;
+            }
+        }
+    }
+
+    /*
+     a session of 500 instances being saved and reloaded, in the binary state and in the
+     ValueTree format it replaced, which setStateInformation() still reads.
+     */
+    void benchmarkState()
+    {
+        constexpr int numInstances = 500;
+
+        std::vector<std::unique_ptr<SimpleEQAudioProcessor>> processors;
+        for( int i = 0; i < numInstances; ++i )
+            processors.push_back(std::make_unique<SimpleEQAudioProcessor>());
+
+        std::vector<juce::MemoryBlock> binaryStates((size_t)numInstances), treeStates((size_t)numInstances);
+
+        auto getMilliseconds = [](auto&& function)
+        {
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            function();
+            return juce::Time::getMillisecondCounterHiRes() - start;
+        };
+
+        auto forEachInstance = [&](auto&& function)
+        {
+            return getMilliseconds([&]
+            {
+                for( size_t i = 0; i < processors.size(); ++i )
+                    function(*processors[i], binaryStates[i], treeStates[i]);
+            });
+        };
+
+        const auto binarySave = forEachInstance([](auto& processor, auto& binary, auto&)
+        {
+            binary.reset();
+            processor.getStateInformation(binary);
+        });
+
+        const auto binaryLoad = forEachInstance([](auto& processor, auto& binary, auto&)
+        {
+            processor.setStateInformation(binary.getData(), (int)binary.getSize());
+        });
+
+        const auto treeSave = forEachInstance([](auto& processor, auto&, auto& tree)
+        {
+            juce::MemoryOutputStream stream(tree, false);
+            processor.apvts.state.writeToStream(stream);
+        });
+
+        const auto treeLoad = forEachInstance([](auto& processor, auto&, auto& tree)
+        {
+            processor.setStateInformation(tree.getData(), (int)tree.getSize());
+        });
+
+        std::cout << "State of " << numInstances << " instances, ms to save / load, bytes each" << std::endl
+                  << "  binary    " << juce::String(binarySave, 1).paddedLeft(' ', 8) << " / "
+                  << juce::String(binaryLoad, 1).paddedLeft(' ', 8) << juce::String((int)binaryStates[0].getSize()).paddedLeft(' ', 8) << std::endl
+                  << "  ValueTree " << juce::String(treeSave, 1).paddedLeft(' ', 8) << " / "
+                  << juce::String(treeLoad, 1).paddedLeft(' ', 8) << juce::String((int)treeStates[0].getSize()).paddedLeft(' ', 8) << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    // the processor's timer and the chat client need a message manager, even if nothing is dispatched
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ScopedNoDenormals noDenormals;
+
+    const juce::String which = argc > 1 ? argv[1] : "";
+
+    if( which.isEmpty() || which == "stages" )
+        benchmarkStages();
+
+    if( which.isEmpty() || which == "precision" )
+        benchmarkPrecision();
+
+    if( which.isEmpty() || which == "state" )
+        benchmarkState();
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    CandidatePreviews.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "CandidatePreviews.h"
+#include "PluginProcessor.h"
+
+bool PreviewLoopCapture::getLoop(juce::AudioBuffer<float>& loop, double& loopSampleRate) const
+{
+    const juce::ScopedLock sl(lock);
+
+    const auto ringSize = ring.getNumSamples();
+    const auto fadeLength = (int)(wrapFadeSeconds * sampleRate);
+    const auto end = numWritten.load(std::memory_order_acquire);
+
+    // the fade needs the audio from before the loop as well
+    const auto loopLength = (int)juce::jmin((juce::int64)(loopSeconds * sampleRate), end - fadeLength);
+    if( ringSize == 0 || loopLength < (int)sampleRate )
+        return false;
+
+    const auto start = end - loopLength;
+    loop.setSize(ring.getNumChannels(), loopLength);
+
+    auto readRing = [this, ringSize](int channel, juce::int64 index)
+    {
+        return ring.getSample(channel, (int)(index % ringSize));
+    };
+
+    for( int channel = 0; channel < ring.getNumChannels(); ++channel )
+    {
+        auto* destination = loop.getWritePointer(channel);
+
+        for( int sample = 0; sample < loopLength; ++sample )
+            destination[sample] = readRing(channel, start + sample);
+
+        // by the end of the loop it has turned into what led up to its start, so the wrap is seamless
+        for( int sample = 0; sample < fadeLength; ++sample )
+        {
+            const auto fade = (float)(sample + 1) / (float)fadeLength;
+            auto& value = destination[loopLength - fadeLength + sample];
+            value += (readRing(channel, start - fadeLength + sample) - value) * fade;
+        }
+    }
+
+    loopSampleRate = sampleRate;
+    return true;
+}
+
+//==============================================================================
+void CandidateAudition::setPreview(int candidate, juce::AudioBuffer<float>&& preview)
+{
+    if( ! juce::isPositiveAndBelow(candidate, maxCandidates) )
+        return;
+
+    // a swap only moves pointers, so the old preview is freed here rather than while the audio thread waits
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        std::swap(previews[(size_t)candidate], preview);
+    }
+}
+
+void CandidateAudition::clear()
+{
+    select(-1);
+
+    std::array<juce::AudioBuffer<float>, maxCandidates> old;
+    {
+        const juce::SpinLock::ScopedLockType sl(lock);
+        std::swap(previews, old);
+    }
+}
+
+//==============================================================================
+class CandidatePreviewRenderer::RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(CandidatePreviewRenderer& ownerToUse, int generationToUse, int candidateToUse,
+              std::shared_ptr<const juce::AudioBuffer<float>> loopToUse, double sampleRateToUse, const ChainSettings& settingsToUse)
+        : juce::ThreadPoolJob("Candidate preview"),
+          owner(ownerToUse),
+          generation(generationToUse),
+          candidate(candidateToUse),
+          loop(std::move(loopToUse)),
+          sampleRate(sampleRateToUse),
+          settings(settingsToUse)
+    {
+    }
+
+    JobStatus runJob() override
+    {
+        juce::ScopedNoDenormals noDenormals;
+
+        const auto numChannels = loop->getNumChannels();
+        const auto numSamples = loop->getNumSamples();
+
+        // far too big for a worker's stack, and this job's alone
+        auto chain = std::make_unique<ProcessingChain<float>>();
+        chain->prepare({ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels });
+
+        auto snapshot = makeChainSnapshot(settings, sampleRate);
+        snapshot.generation = 1;
+        chain->applySnapshot(snapshot);
+
+        const auto stages = getActiveStages(settings);
+
+        juce::AudioBuffer<float> preview(numChannels, numSamples);
+
+        // twice round, keeping the second: the delay and reverb tails then carry over the wrap
+        // just like they will when the preview plays on repeat
+        for( int pass = 0; pass < 2; ++pass )
+        {
+            for( int start = 0; start < numSamples; start += blockSize )
+            {
+                if( isStale() )
+                    return jobHasFinished;
+
+                const auto length = juce::jmin(blockSize, numSamples - start);
+                for( int channel = 0; channel < numChannels; ++channel )
+                    preview.copyFrom(channel, start, *loop, channel, start, length);
+
+                juce::dsp::AudioBlock<float> block(preview.getArrayOfWritePointers(), (size_t)numChannels, (size_t)start, (size_t)length);
+                chain->process(block, stages);
+            }
+        }
+
+        {
+            const juce::ScopedLock sl(owner.deliverLock);
+            if( isStale() )
+                return jobHasFinished;
+
+            owner.audition.setPreview(candidate, std::move(preview));
+        }
+
+        juce::MessageManager::callAsync([weakOwner = juce::WeakReference<CandidatePreviewRenderer>(&owner),
+                                         renderGeneration = generation, readyCandidate = candidate]
+        {
+            if( weakOwner != nullptr && weakOwner->generation.load() == renderGeneration && weakOwner->onPreviewReady )
+                weakOwner->onPreviewReady(readyCandidate);
+        });
+
+        return jobHasFinished;
+    }
+
+private:
+    CandidatePreviewRenderer& owner;
+    const int generation, candidate;
+    const std::shared_ptr<const juce::AudioBuffer<float>> loop;
+    const double sampleRate;
+    ChainSettings settings;
+
+    bool isStale() const { return shouldExit() || owner.generation.load() != generation; }
+};
+
+CandidatePreviewRenderer::CandidatePreviewRenderer(CandidateAudition& auditionToUse)
+    : audition(auditionToUse)
+{
+    // jobs take weak references from their own threads, so the shared part has to exist before any start
+    juce::WeakReference<CandidatePreviewRenderer> { this };
+}
+
+CandidatePreviewRenderer::~CandidatePreviewRenderer()
+{
+    cancel();
+    pool.removeAllJobs(true, 5000);
+}
+
+void CandidatePreviewRenderer::render(const juce::AudioBuffer<float>& loop, double sampleRate, const std::vector<ChainSettings>& candidates)
+{
+    cancel();
+
+    const auto renderGeneration = generation.load();
+    auto sharedLoop = std::make_shared<const juce::AudioBuffer<float>>(loop);
+
+    for( int candidate = 0; candidate < juce::jmin((int)candidates.size(), CandidateAudition::maxCandidates); ++candidate )
+    {
+        auto settings = candidates[(size_t)candidate];
+
+        // the linear phase kernel is designed on the processor's own thread, and the host's sidechain
+        // isn't part of the loop, so a preview uses the minimum phase EQ and its own detector
+        settings.linearPhase = false;
+        settings.compSidechain = false;
+
+        pool.addJob(new RenderJob(*this, renderGeneration, candidate, sharedLoop, sampleRate, settings), true);
+    }
+}
+
+void CandidatePreviewRenderer::cancel()
+{
+    {
+        const juce::ScopedLock sl(deliverLock);
+        ++generation;
+        audition.clear();
+    }
+
+    // jobs still running notice the new generation and stop at their next block
+    pool.removeAllJobs(true, 0);
+}
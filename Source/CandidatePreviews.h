@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    CandidatePreviews.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ChainSnapshot.h"
+
+/**
+ The last few seconds of the plugin's input, so suggestions can be heard on the user's own
+ audio. The audio thread writes it, anything else may take a copy of the newest loop.
+ */
+struct PreviewLoopCapture
+{
+    static constexpr double loopSeconds = 4.0;
+
+    // enough that the loop being copied is never what the audio thread is writing to
+    static constexpr double marginSeconds = 1.0;
+
+    // the length of the fade that hides the loop's wrap
+    static constexpr double wrapFadeSeconds = 0.01;
+
+    static constexpr int maxLoopChannels = 2;
+
+    /** call while the audio thread isn't running, e.g. from prepareToPlay() */
+    void prepare(double newSampleRate, int numChannels)
+    {
+        const juce::ScopedLock sl(lock);
+
+        sampleRate = newSampleRate;
+        ring.setSize(juce::jlimit(1, maxLoopChannels, numChannels), (int)std::ceil((loopSeconds + marginSeconds) * sampleRate));
+        ring.clear();
+        numWritten.store(0);
+    }
+
+    /** audio thread: only non-silent blocks are worth keeping, a stopped transport would overwrite the loop */
+    template<typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& buffer)
+    {
+        const auto ringSize = ring.getNumSamples();
+        if( ringSize == 0 || buffer.getNumChannels() == 0 )
+            return;
+
+        auto written = numWritten.load(std::memory_order_relaxed);
+        const auto numSamples = juce::jmin(buffer.getNumSamples(), ringSize);
+
+        for( int channel = 0; channel < ring.getNumChannels(); ++channel )
+        {
+            auto* source = buffer.getReadPointer(juce::jmin(channel, buffer.getNumChannels() - 1));
+            auto* destination = ring.getWritePointer(channel);
+            auto position = (int)(written % ringSize);
+
+            for( int sample = 0; sample < numSamples; ++sample )
+            {
+                destination[position] = static_cast<float>(source[sample]);
+                if( ++position == ringSize )
+                    position = 0;
+            }
+        }
+
+        numWritten.store(written + numSamples, std::memory_order_release);
+    }
+
+    /*
+     copies the newest loop (up to loopSeconds of it) into 'loop', its end faded into the audio
+     that came just before its start so it repeats without a click. False if there's less than
+     a second of it so far.
+     */
+    bool getLoop(juce::AudioBuffer<float>& loop, double& loopSampleRate) const;
+private:
+    juce::CriticalSection lock;
+    juce::AudioBuffer<float> ring;
+    double sampleRate = 44100.0;
+    std::atomic<juce::int64> numWritten { 0 };
+};
+
+/**
+ Plays a rendered preview in place of the chain's output, so candidates can be switched between
+ instantly, and back to the live chain. Every preview plays from the same position, so an A/B
+ switch lands on the same beat, and switches crossfade over one block.
+ */
+struct CandidateAudition
+{
+    static constexpr int maxCandidates = 4;
+
+    /** any thread but the audio thread */
+    void setPreview(int candidate, juce::AudioBuffer<float>&& preview);
+    void clear();
+
+    /** -1 for the live chain */
+    void select(int candidate) { selected.store(juce::jlimit(-1, maxCandidates - 1, candidate)); }
+    int getSelected() const { return selected.load(); }
+
+    /*
+     audio thread: replaces 'buffer' with the selected preview, or does nothing when the live chain
+     is selected (and not still being faded back to). Returns whether it wrote anything.
+     */
+    template<typename SampleType>
+    bool process(juce::AudioBuffer<SampleType>& buffer)
+    {
+        // the previews are only being swapped while new ones arrive, the live output will do until then
+        const juce::SpinLock::ScopedTryLockType tryLock(lock);
+        if( ! tryLock.isLocked() )
+            return false;
+
+        auto isPlayable = [this](int candidate) { return candidate >= 0 && previews[(size_t)candidate].getNumSamples() > 0; };
+
+        const auto target = isPlayable(selected.load()) ? selected.load() : -1;
+        if( ! isPlayable(playing) )
+            playing = -1;
+
+        if( target < 0 && playing < 0 )
+            return false;
+
+        const auto numSamples = buffer.getNumSamples();
+
+        auto read = [this](int candidate, int channel, int sample)
+        {
+            const auto& preview = previews[(size_t)candidate];
+            return preview.getSample(channel % preview.getNumChannels(), (int)((position + sample) % preview.getNumSamples()));
+        };
+
+        for( int channel = 0; channel < buffer.getNumChannels(); ++channel )
+        {
+            auto* samples = buffer.getWritePointer(channel);
+
+            for( int sample = 0; sample < numSamples; ++sample )
+            {
+                const auto live = static_cast<float>(samples[sample]);
+                const auto from = playing >= 0 ? read(playing, channel, sample) : live;
+
+                if( target == playing )
+                {
+                    samples[sample] = static_cast<SampleType>(from);
+                    continue;
+                }
+
+                const auto to = target >= 0 ? read(target, channel, sample) : live;
+                const auto fade = (float)(sample + 1) / (float)numSamples;
+                samples[sample] = static_cast<SampleType>(from + (to - from) * fade);
+            }
+        }
+
+        position += numSamples;
+        playing = target;
+        return true;
+    }
+private:
+    juce::SpinLock lock;
+    std::array<juce::AudioBuffer<float>, maxCandidates> previews;
+    std::atomic<int> selected { -1 };
+
+    // audio thread only
+    int playing = -1;
+    juce::int64 position = 0;
+};
+
+/**
+ Renders the captured loop through each candidate's settings on a pool of threads, every one
+ with a ProcessingChain of its own, so nothing is shared with the audio thread or between them.
+ Nothing waits on the audio device either, so a preview is ready in a fraction of the loop's length.
+ */
+class CandidatePreviewRenderer
+{
+public:
+    explicit CandidatePreviewRenderer(CandidateAudition& auditionToUse);
+    ~CandidatePreviewRenderer();
+
+    /** drops the previews there are and anything still rendering, then renders one per candidate */
+    void render(const juce::AudioBuffer<float>& loop, double sampleRate, const std::vector<ChainSettings>& candidates);
+
+    void cancel();
+
+    // called on the message thread as each preview is handed to the audition
+    std::function<void(int candidate)> onPreviewReady;
+private:
+    class RenderJob;
+
+    static constexpr int blockSize = 512;
+
+    CandidateAudition& audition;
+
+    // previews from an earlier render() are dropped rather than handed over
+    juce::CriticalSection deliverLock;
+    std::atomic<int> generation { 0 };
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(CandidatePreviewRenderer)
+
+    // last, so it is the first to go and waits for its jobs while everything they use still exists
+    juce::ThreadPool pool { juce::jlimit(1, CandidateAudition::maxCandidates, juce::SystemStats::getNumCpus() - 1) };
+};
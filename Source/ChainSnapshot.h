@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    ChainSnapshot.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <complex>
+#include <type_traits>
+
+enum Slope
+{
+    Slope_12,
+    Slope_24,
+    Slope_36,
+    Slope_48
+};
+
+struct ChainSettings
+{
+    float peakFreq { 0 }, peakGainInDecibels{ 0 }, peakQuality {1.f};
+    float lowCutFreq { 0 }, highCutFreq { 0 };
+
+    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+
+    bool lowCutBypassed { false }, peakBypassed { false }, highCutBypassed { false };
+
+    bool linearPhase { false };
+    int linearPhaseKernelSize { 4096 };
+
+    float compThreshold { 0 }, compRatio { 1.f }, compAttack { 1.f }, compRelease { 10.f };
+    
+    struct CompressorBand
+    {
+        float threshold { 0 }, ratio { 1.f }, attack { 1.f }, release { 10.f };
+    };
+    
+    bool compMultiband { false };
+    int compBands { 3 };
+    float compCrossoverLow { 150.f }, compCrossoverMid { 1500.f }, compCrossoverHigh { 6000.f };
+    std::array<CompressorBand, 4> compBandSettings;
+    
+    bool compSidechain { false };
+    float compSidechainHighPass { 20.f };
+    
+    float distortionAmount { 1.f };
+    float delayTimeMs { 1.f }, delayFeedback { 0 }, delayMix { 0 };
+    float reverbSize { 0 }, reverbDecay { 0 }, reverbMix { 0 };
+
+    bool compBypassed { false }, distortionBypassed { false }, delayBypassed { false }, reverbBypassed { false };
+    
+    // index into the permutations of the stages, see getChainOrder()
+    int chainOrder { 0 };
+    
+    float morphTimeSeconds { 2.f }, morphPosition { 1.f };
+};
+
+/*
+ the settings 'position' of the way from 'from' to 'to', moving each parameter in the domain
+ it's heard in: frequencies, Q, ratios and times geometrically, levels in dB and everything
+ else linearly. Switches, slopes and choices always come from 'to'.
+ */
+inline ChainSettings morphChainSettings(const ChainSettings& from, const ChainSettings& to, float position)
+{
+    auto linear = [position](float a, float b) { return a + (b - a) * position; };
+    auto geometric = [position](float a, float b)
+    {
+        return a > 0.f && b > 0.f ? a * std::pow(b / a, position) : a + (b - a) * position;
+    };
+    
+    auto result = to;
+    
+    result.peakFreq = geometric(from.peakFreq, to.peakFreq);
+    result.peakGainInDecibels = linear(from.peakGainInDecibels, to.peakGainInDecibels);
+    result.peakQuality = geometric(from.peakQuality, to.peakQuality);
+    result.lowCutFreq = geometric(from.lowCutFreq, to.lowCutFreq);
+    result.highCutFreq = geometric(from.highCutFreq, to.highCutFreq);
+    
+    result.compThreshold = linear(from.compThreshold, to.compThreshold);
+    result.compRatio = geometric(from.compRatio, to.compRatio);
+    result.compAttack = geometric(from.compAttack, to.compAttack);
+    result.compRelease = geometric(from.compRelease, to.compRelease);
+    result.compSidechainHighPass = geometric(from.compSidechainHighPass, to.compSidechainHighPass);
+    
+    result.compCrossoverLow = geometric(from.compCrossoverLow, to.compCrossoverLow);
+    result.compCrossoverMid = geometric(from.compCrossoverMid, to.compCrossoverMid);
+    result.compCrossoverHigh = geometric(from.compCrossoverHigh, to.compCrossoverHigh);
+    
+    for( size_t band = 0; band < result.compBandSettings.size(); ++band )
+    {
+        const auto& a = from.compBandSettings[band];
+        const auto& b = to.compBandSettings[band];
+        auto& morphed = result.compBandSettings[band];
+        
+        morphed.threshold = linear(a.threshold, b.threshold);
+        morphed.ratio = geometric(a.ratio, b.ratio);
+        morphed.attack = geometric(a.attack, b.attack);
+        morphed.release = geometric(a.release, b.release);
+    }
+    
+    result.distortionAmount = linear(from.distortionAmount, to.distortionAmount);
+    result.delayTimeMs = linear(from.delayTimeMs, to.delayTimeMs);
+    result.delayFeedback = linear(from.delayFeedback, to.delayFeedback);
+    result.delayMix = linear(from.delayMix, to.delayMix);
+    result.reverbSize = linear(from.reverbSize, to.reverbSize);
+    result.reverbDecay = linear(from.reverbDecay, to.reverbDecay);
+    result.reverbMix = linear(from.reverbMix, to.reverbMix);
+    
+    return result;
+}
+
+/**
+ A second order IIR section in the layout juce::dsp::IIR::Coefficients uses internally:
+ b0, b1, b2, a1, a2, all normalised so that a0 == 1.
+ Plain data, so it can live inside a snapshot that is copied between threads, and designed
+ in double so the double precision chain gets the full benefit.
+ */
+struct BiquadCoefficients
+{
+    std::array<double, 5> values { 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+    static BiquadCoefficients fromArray(const std::array<double, 6>& c)
+    {
+        // ArrayCoefficients gives us b0, b1, b2, a0, a1, a2
+        const auto a0Inv = 1.0 / c[3];
+        return { { c[0] * a0Inv, c[1] * a0Inv, c[2] * a0Inv, c[4] * a0Inv, c[5] * a0Inv } };
+    }
+
+    double getMagnitudeForFrequency(double frequency, double sampleRate) const
+    {
+        const std::complex<double> jw = std::polar(1.0, -juce::MathConstants<double>::twoPi * frequency / sampleRate);
+        const auto jw2 = jw * jw;
+
+        auto numerator = values[0] + values[1] * jw + values[2] * jw2;
+        auto denominator = 1.0 + values[3] * jw + values[4] * jw2;
+
+        return std::abs(numerator / denominator);
+    }
+    
+    /** how long the impulse response of this section takes to fall by 'attenuationInDecibels' */
+    double getDecayInSamples(double attenuationInDecibels) const
+    {
+        const double a1 = values[3], a2 = values[4];
+        const double discriminant = a1 * a1 - 4.0 * a2;
+        
+        auto poleRadius = discriminant < 0.0 ? std::sqrt(a2)
+                                             : 0.5 * juce::jmax(std::abs(-a1 + std::sqrt(discriminant)),
+                                                                std::abs(-a1 - std::sqrt(discriminant)));
+        
+        if( poleRadius <= 0.0 )
+            return 2.0; // no feedback, just the two sample FIR part
+        
+        return attenuationInDecibels / (-20.0 * std::log10(juce::jmin(poleRadius, 0.999999)));
+    }
+};
+
+struct CutCoefficients
+{
+    std::array<BiquadCoefficients, 4> stages;
+    int numStages = 1;
+};
+
+/*
+ the filter design functions. They don't allocate, so the audio thread can call them
+ while it smooths parameters as well.
+ */
+BiquadCoefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate);
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate);
+
+/**
+ Everything the audio thread and the response curve need to render the chain,
+ with the filter coefficients already designed for 'sampleRate'.
+ */
+struct ChainSnapshot
+{
+    ChainSettings settings;
+    double sampleRate { 44100.0 };
+
+    BiquadCoefficients peak;
+    CutCoefficients lowCut, highCut;
+    
+    // how long the active stages keep ringing after the input goes silent
+    double tailSeconds { 0.0 };
+    
+    // bumped for every preset that should be morphed to rather than jumped to
+    juce::uint32 morphId { 0 };
+
+    juce::uint32 generation { 0 };
+};
+
+/** the combined magnitude of the EQ filters that aren't bypassed */
+inline double getEQMagnitudeForFrequency(const ChainSnapshot& snapshot, double frequency)
+{
+    const auto& settings = snapshot.settings;
+    double mag = 1.0;
+    
+    if( !settings.peakBypassed )
+        mag *= snapshot.peak.getMagnitudeForFrequency(frequency, snapshot.sampleRate);
+    
+    if( !settings.lowCutBypassed )
+    {
+        for( int stage = 0; stage < snapshot.lowCut.numStages; ++stage )
+            mag *= snapshot.lowCut.stages[stage].getMagnitudeForFrequency(frequency, snapshot.sampleRate);
+    }
+    
+    if( !settings.highCutBypassed )
+    {
+        for( int stage = 0; stage < snapshot.highCut.numStages; ++stage )
+            mag *= snapshot.highCut.stages[stage].getMagnitudeForFrequency(frequency, snapshot.sampleRate);
+    }
+    
+    return mag;
+}
+
+/**
+ Multi-reader publication of a trivially copyable value. publish() must never run on two
+ threads at once, so callers serialise it: the processor publishes chain snapshots from
+ both the message thread and the audio thread, under its publishLock.
+ The writer fills whichever of the two slots readers aren't pointed at and then flips
+ 'current'. Each slot carries a sequence counter (odd while being written), and read()
+ retries while it finds it odd or changed, so a reader spins for as long as a write to
+ its slot is in progress: normally one copy of T, longer only if publishes land back to
+ back. publish() never waits for readers, and neither side allocates.
+ */
+template<typename T>
+struct SnapshotBuffer
+{
+    static_assert( std::is_trivially_copyable_v<T>,
+                  "SnapshotBuffer copies values with plain assignment while readers may be looking");
+
+    void publish(const T& t)
+    {
+        auto back = 1 - current.load(std::memory_order_relaxed);
+        auto& slot = slots[back];
+
+        auto sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.value = t;
+
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        current.store(back, std::memory_order_release);
+    }
+
+    T read() const
+    {
+        for( ;; )
+        {
+            const auto& slot = slots[current.load(std::memory_order_acquire)];
+
+            auto before = slot.sequence.load(std::memory_order_acquire);
+            if( before & 1 )
+                continue;
+
+            T copy = slot.value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if( slot.sequence.load(std::memory_order_relaxed) == before )
+                return copy;
+        }
+    }
+private:
+    struct Slot
+    {
+        std::atomic<juce::uint32> sequence { 0 };
+        T value {};
+    };
+
+    std::array<Slot, 2> slots;
+    std::atomic<int> current { 0 };
+};
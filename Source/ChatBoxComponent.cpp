@@ -23,6 +23,11 @@ ChatBoxComponent::ChatBoxComponent()
     sendButton.setButtonText("Send");
     sendButton.addListener(this);
     addAndMakeVisible(sendButton);
+
+    // Request status
+    statusLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
+    statusLabel.setFont(juce::Font(14.0f));
+    addAndMakeVisible(statusLabel);
 }
 
 void ChatBoxComponent::resized()
@@ -31,8 +36,11 @@ void ChatBoxComponent::resized()
 
     auto inputHeight = 30;
     auto buttonWidth = 60;
+    auto statusHeight = 18;
 
-    chatDisplay.setBounds(bounds.removeFromTop(bounds.getHeight() - inputHeight - 10));
+    chatDisplay.setBounds(bounds.removeFromTop(bounds.getHeight() - inputHeight - statusHeight - 10));
+    statusLabel.setBounds(bounds.removeFromTop(statusHeight));
+    bounds.removeFromTop(4);
     inputBox.setBounds(bounds.removeFromLeft(bounds.getWidth() - buttonWidth - 10));
     sendButton.setBounds(bounds);
 }
@@ -53,24 +61,74 @@ void ChatBoxComponent::buttonClicked(juce::Button* button)
         {
             inputBox.clear();
 
+            // the client queues the request, so nothing here blocks the message thread
             if (onUserMessage)
-            {
-                // Ensure the callback runs on a non-GUI thread if it needs to be
-                std::function<void()> safeCallback = [cb = onUserMessage, message]() {
-                    cb(message);
-                };
-
-                std::thread(std::move(safeCallback)).detach(); // run in background if needed
-            }
+                onUserMessage(message);
         }
     }
 }
 
 void ChatBoxComponent::appendMessage(const juce::String& speaker, const juce::String& message)
 {
-    // Ensure GUI update happens on the message thread
-    juce::MessageManager::callAsync([this, speaker, message]() {
-        chatDisplay.moveCaretToEnd();
-        chatDisplay.insertTextAtCaret(speaker + ": " + message + "\n");
+    // Ensure GUI update happens on the message thread, and not at all once the editor has closed
+    juce::MessageManager::callAsync([safeThis = SafePointer<ChatBoxComponent>(this), speaker, message]() {
+        if (safeThis == nullptr)
+            return;
+
+        safeThis->chatDisplay.moveCaretToEnd();
+        safeThis->chatDisplay.insertTextAtCaret(speaker + ": " + message + "\n");
+
+        if (safeThis->onTranscriptChanged)
+            safeThis->onTranscriptChanged();
+    });
+}
+
+void ChatBoxComponent::beginMessage(const juce::String& speaker)
+{
+    juce::MessageManager::callAsync([safeThis = SafePointer<ChatBoxComponent>(this), speaker]() {
+        if (safeThis == nullptr)
+            return;
+
+        safeThis->chatDisplay.moveCaretToEnd();
+        safeThis->chatDisplay.insertTextAtCaret(speaker + ": ");
+    });
+}
+
+void ChatBoxComponent::appendToMessage(const juce::String& text)
+{
+    juce::MessageManager::callAsync([safeThis = SafePointer<ChatBoxComponent>(this), text]() {
+        if (safeThis == nullptr)
+            return;
+
+        safeThis->chatDisplay.moveCaretToEnd();
+        safeThis->chatDisplay.insertTextAtCaret(text);
+    });
+}
+
+void ChatBoxComponent::endMessage()
+{
+    juce::MessageManager::callAsync([safeThis = SafePointer<ChatBoxComponent>(this)]() {
+        if (safeThis == nullptr)
+            return;
+
+        safeThis->chatDisplay.moveCaretToEnd();
+        safeThis->chatDisplay.insertTextAtCaret("\n");
+
+        if (safeThis->onTranscriptChanged)
+            safeThis->onTranscriptChanged();
+    });
+}
+
+void ChatBoxComponent::setTranscript(const juce::String& transcript)
+{
+    chatDisplay.setText(transcript, false);
+    chatDisplay.moveCaretToEnd();
+}
+
+void ChatBoxComponent::setStatus(const juce::String& status)
+{
+    juce::MessageManager::callAsync([safeThis = SafePointer<ChatBoxComponent>(this), status]() {
+        if (safeThis != nullptr)
+            safeThis->statusLabel.setText(status, juce::dontSendNotification);
     });
 }
@@ -17,10 +17,25 @@ public:
 
     void appendMessage(const juce::String& speaker, const juce::String& message);
 
+    // a message that arrives in pieces: begin it, append as often as needed, then end it
+    void beginMessage(const juce::String& speaker);
+    void appendToMessage(const juce::String& text);
+    void endMessage();
+
+    juce::String getTranscript() const { return chatDisplay.getText(); }
+    void setTranscript(const juce::String& transcript);
+
+    // called on the message thread whenever a message has been added
+    std::function<void()> onTranscriptChanged;
+
+    // a line under the chat saying what the request in flight is doing, or nothing when there isn't one
+    void setStatus(const juce::String& status);
+
 private:
     juce::TextEditor chatDisplay;
     juce::TextEditor inputBox;
     juce::TextButton sendButton;
+    juce::Label statusLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ChatBoxComponent)
 };
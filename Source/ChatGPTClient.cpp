@@ -9,159 +9,406 @@
 */
 
 #include "ChatGPTClient.h"
-#include "BinaryData.h"
 #include <fstream>
+#include <cstring>
 
-ChatGPTClient::ChatGPTClient()
-    : Thread("ChatGPTClientThread")
+class ChatGPTClient::RequestJob : public juce::ThreadPoolJob
 {
-    // Optional system message to establish context
-    const juce::String systemPrompt = "You are an expert audio engineer assistant. Your job is to listen to a user's prompt and output the appropriate EQ and Compressor settings that would match the described genre, artist, or style. You will also be provided with the current state of the EQ and Compressor settings in JSON format. You will return a JSON object that specifies the frequency, gain (in dB), and Q factor for each EQ band; the threshold, ratio, attack, and release for the compressor; the amount for the distortion; the time (ms), feedback, and mix percentage for the delay; and the size, decay (s), and mix percentage for the reverb.  Take care to match the format given in each prompt. You should focus on matching the tonal character and mix aesthetic described by the user. Use musical intuition and common mixing practices when making choices.";
+public:
+    RequestJob(ChatGPTClient& ownerToUse, int requestIdToUse, const juce::String& text, const juce::String& attachmentToSend)
+        : juce::ThreadPoolJob("Chat request"),
+          owner(ownerToUse),
+          requestId(requestIdToUse),
+          message(text),
+          attachment(attachmentToSend),
+          sendTime(juce::Time::getMillisecondCounterHiRes() + coalesceTimeMs)
+    {
+    }
 
-    resetConversation(systemPrompt);  // <-- Reset chat on startup with system prompt
-    startThread();
-    
-    
-    apiKey = loadApiKeyFromConfig();
-    apiURL = "https://api.openai.com/v1/chat/completions";
-}
+    // only while it's pending, with the owner's lock held
+    void coalesce(int newRequestId, const juce::String& text, const juce::String& newAttachment)
+    {
+        requestId = newRequestId;
+        message << "\n" << text;
+        attachment = newAttachment;
+        sendTime = juce::Time::getMillisecondCounterHiRes() + coalesceTimeMs;
+    }
 
-ChatGPTClient::~ChatGPTClient()
-{
-    stopThread(500);
-}
+    JobStatus runJob() override
+    {
+        if (! waitUntilDue())
+            return jobHasFinished;
 
-// Utility function to load API key from embedded config.json
-juce::String ChatGPTClient::loadApiKeyFromConfig()
-{
-    // Load the JSON text from binary resource
-    juce::String jsonText = juce::String::fromUTF8(BinaryData::config_json, BinaryData::config_jsonSize);
+        // Create request body from as much of the history as the backend's budget allows
+        juce::String body;
+        std::shared_ptr<LLMBackend> backend;
+        {
+            const juce::ScopedLock sl(owner.lock);
+            backend = owner.backend;
+
+            if (backend == nullptr || shouldExit())
+                return finish(RequestStatus::failed, "no backend");
+
+            owner.context.addUserTurn(message, attachment);
+
+            auto messages = owner.context.buildMessages(backend->getOptions().contextTokenBudget, owner.lastRequestStats);
+            body = backend->createRequestBody(messages, owner.responseSchema);
+        }
+
+        // other instances may already be using every request this backend allows
+        auto slot = backend->acquireRequestSlot([this] { return shouldExit(); });
+        if (! slot.isValid())
+            return finish(RequestStatus::failed);
+
+        owner.postStatus(requestId, RequestStatus::sending);
+
+        requestStart = juce::Time::getMillisecondCounterHiRes();
+        metrics.bytesSent = body.getNumBytesAsUTF8();
 
-    // Attempt to parse the JSON
-    juce::var parsedJson = juce::JSON::parse(jsonText);
-    if (parsedJson.isObject())
+        auto response = backend->send(body,
+                                      [this] { return shouldExit(); },
+                                      [this](const juce::String& reason, int delayMs)
+                                      {
+                                          owner.postStatus(requestId, RequestStatus::queued,
+                                                           reason + ", retrying in " + juce::String(delayMs / 1000.0, 1) + " s");
+                                      });
+
+        metrics.statusCode = response.statusCode;
+        metrics.numAttempts = response.numAttempts;
+        metrics.headersMs = juce::Time::getMillisecondCounterHiRes() - requestStart;
+
+        if (! response.succeeded())
+            return finish(RequestStatus::failed, response.error);
+
+        auto reply = readReply(*response.stream, *backend);
+        metrics.totalMs = juce::Time::getMillisecondCounterHiRes() - requestStart;
+
+        {
+            const juce::ScopedLock sl(owner.lock);
+
+            // superseded: its answer is never applied, nor remembered as part of the conversation
+            if (shouldExit())
+                return finish(RequestStatus::failed);
+
+            owner.lastRequestMetrics = metrics;
+
+            if (reply.isEmpty())
+                return finish(RequestStatus::failed, "the reply was empty");
+
+            owner.context.addAssistantReply(reply);
+        }
+
+        owner.postToMessageThread(requestId, [reply](ChatGPTClient& client)
+        {
+            if (client.onResponse)
+                client.onResponse(reply);
+        });
+
+        return finish(RequestStatus::finished);
+    }
+
+private:
+    ChatGPTClient& owner;
+
+    // guarded by the owner's lock while the job is pending
+    int requestId;
+    juce::String message, attachment;
+    double sendTime;
+
+    StreamingResponseParser parser;
+    bool receiving = false;
+
+    double requestStart = 0;
+    RequestMetrics metrics;
+
+    // waits out the time for another message to be coalesced, false if cancelled meanwhile
+    bool waitUntilDue()
     {
-        if (auto* obj = parsedJson.getDynamicObject())
+        for (;;)
         {
-            if (obj->hasProperty("openai_api_key"))
+            double remaining;
             {
-                auto apiKey = obj->getProperty("openai_api_key").toString();
-                DBG("Loaded API key from BinaryData: " + apiKey);
-                return apiKey;
+                const juce::ScopedLock sl(owner.lock);
+                if (shouldExit())
+                {
+                    if (owner.pendingJob == this)
+                        owner.pendingJob = nullptr;
+
+                    return false;
+                }
+
+                remaining = sendTime - juce::Time::getMillisecondCounterHiRes();
+                if (remaining <= 0)
+                {
+                    // on its way from here, so a new message supersedes it rather than joining it
+                    if (owner.pendingJob == this)
+                        owner.pendingJob = nullptr;
+
+                    owner.runningJobs.add(this);
+                    return true;
+                }
             }
+
+            juce::Thread::sleep(juce::jlimit(1, 50, (int)remaining));
         }
     }
 
-    DBG("API key not found or failed to parse embedded config.json.");
-    return {};
-}
+    JobStatus finish(RequestStatus status, const juce::String& detail = {})
+    {
+        {
+            const juce::ScopedLock sl(owner.lock);
+            owner.runningJobs.removeFirstMatchingValue(this);
+        }
 
-void ChatGPTClient::sendMessageAsync(const juce::String& userMessage)
-{
+        // only the newest request reports anything, so a superseded one failing says nothing
+        owner.postStatus(requestId, status, detail);
+        return jobHasFinished;
+    }
+
+    juce::String readReply(juce::InputStream& stream, const LLMBackend& replyBackend)
     {
-        const juce::ScopedLock sl(lock);
-        
-        // Add user message to history
-        juce::DynamicObject::Ptr userMsg = new juce::DynamicObject();
-        userMsg->setProperty("role", "user");
-        userMsg->setProperty("content", userMessage);
-        messageHistory.add(juce::var(userMsg.get()));
-        
-        latestUserMessage = userMessage;
-        shouldSend = true;
+        parser.reset();
+
+        parser.onText = [this](const juce::String& text)
+        {
+            notifyReceiving();
+            owner.postToMessageThread(requestId, [text](ChatGPTClient& client)
+            {
+                if (client.onResponseText)
+                    client.onResponseText(text);
+            });
+        };
+
+        parser.onParameter = [this](const ReplyParameter& parameter)
+        {
+            notifyReceiving();
+            owner.postToMessageThread(requestId, [parameter](ChatGPTClient& client)
+            {
+                if (client.onParameter)
+                    client.onParameter(parameter);
+            });
+        };
+
+        juce::String reply, plainBody;
+        bool isEventStream = false;
+
+        // bytes are only turned into text a whole line at a time, so a UTF-8 sequence is never split
+        juce::MemoryBlock pending;
+        char buffer[1024];
+
+        while (! shouldExit() && ! stream.isExhausted())
+        {
+            auto numRead = stream.read(buffer, (int)sizeof(buffer));
+            if (numRead <= 0)
+                break;
+
+            if (metrics.bytesReceived == 0)
+                metrics.firstByteMs = juce::Time::getMillisecondCounterHiRes() - requestStart;
+
+            metrics.bytesReceived += (size_t)numRead;
+
+            pending.append(buffer, (size_t)numRead);
+
+            for (;;)
+            {
+                auto* data = static_cast<const char*>(pending.getData());
+                auto* newline = static_cast<const char*>(std::memchr(data, '\n', pending.getSize()));
+                if (newline == nullptr)
+                    break;
+
+                auto lineLength = (size_t)(newline - data);
+                auto line = juce::String::fromUTF8(data, (int)lineLength);
+                pending.removeSection(0, lineLength + 1);
+
+                handleReplyLine(line, replyBackend, reply, plainBody, isEventStream);
+            }
+        }
+
+        if (shouldExit())
+            return {};
+
+        if (! pending.isEmpty())
+            handleReplyLine(juce::String::fromUTF8(static_cast<const char*>(pending.getData()), (int)pending.getSize()),
+                            replyBackend, reply, plainBody, isEventStream);
+
+        // a server that ignored "stream" sends the whole completion as one JSON body
+        if (! isEventStream)
+        {
+            reply = replyBackend.getCompleteText(juce::JSON::parse(plainBody));
+            parser.feed(reply);
+        }
+
+        parser.finish();
+        return reply.trim();
     }
 
-    notify();
+    void handleReplyLine(const juce::String& rawLine, const LLMBackend& replyBackend,
+                         juce::String& reply, juce::String& plainBody, bool& isEventStream)
+    {
+        auto line = rawLine.trimEnd();
+
+        if (! line.startsWith("data:"))
+        {
+            // comments, "event:" lines and the blank lines between events carry nothing we need
+            if (! isEventStream)
+                plainBody << line << "\n";
+
+            return;
+        }
+
+        isEventStream = true;
+
+        auto payload = line.substring(5).trim();
+        if (payload == "[DONE]")
+            return;
+
+        auto piece = replyBackend.getStreamedText(juce::JSON::parse(payload));
+        if (piece.isNotEmpty())
+        {
+            reply << piece;
+            parser.feed(piece);
+        }
+    }
+
+    void notifyReceiving()
+    {
+        if (! receiving)
+            owner.postStatus(requestId, RequestStatus::receiving);
+
+        receiving = true;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RequestJob)
+};
+
+//==============================================================================
+ChatGPTClient::ChatGPTClient()
+{
+    resetConversation(getDefaultSystemPrompt());  // <-- Reset chat on startup with system prompt
+    backend = makeLLMBackend(getDefaultLLMBackendType());
+
+    // jobs take weak references from their own threads, so the shared part has to exist before any start
+    juce::WeakReference<ChatGPTClient> { this };
 }
 
-void ChatGPTClient::clearHistory()
+ChatGPTClient::~ChatGPTClient()
+{
+    cancelRequests();
+
+    // a request blocked in a read only notices once its connection times out
+    pool.removeAllJobs(true, 10000);
+}
+
+juce::String ChatGPTClient::getDefaultSystemPrompt()
+{
+    return "You are an expert audio engineer assistant. Your job is to listen to a user's prompt and output the appropriate EQ and Compressor settings that would match the described genre, artist, or style. You will also be provided with the current state of the settings. You will return a JSON object that specifies the frequency, gain (in dB), and Q factor for each EQ band; the threshold, ratio, attack, and release for the compressor; the amount for the distortion; the time (ms), feedback, and mix percentage for the delay; and the size, decay (s), and mix percentage for the reverb.  Take care to match the format given below. You should focus on matching the tonal character and mix aesthetic described by the user. Use musical intuition and common mixing practices when making choices.";
+}
+
+void ChatGPTClient::setResponseSchema(const juce::var& schema)
 {
     const juce::ScopedLock sl(lock);
-    messageHistory.clear();
+    responseSchema = schema;
 }
 
-void ChatGPTClient::resetConversation(const juce::String& systemPrompt)
+void ChatGPTClient::setBackend(std::shared_ptr<LLMBackend> newBackend)
 {
+    // a request already on its way finishes with the backend it started with
     const juce::ScopedLock sl(lock);
-    messageHistory.clear();
+    backend = std::move(newBackend);
+}
 
-    if (systemPrompt.isNotEmpty())
-    {
-        juce::DynamicObject::Ptr sysMsg = new juce::DynamicObject();
-        sysMsg->setProperty("role", "system");
-        sysMsg->setProperty("content", systemPrompt);
-        messageHistory.add(juce::var(sysMsg.get()));
-    }
+juce::String ChatGPTClient::getBackendName() const
+{
+    const juce::ScopedLock sl(lock);
+    return backend != nullptr ? backend->getName() : juce::String();
 }
 
-void ChatGPTClient::run()
+void ChatGPTClient::sendMessageAsync(const juce::String& userMessage, const juce::String& attachment)
 {
-    while (!threadShouldExit())
+    const int requestId = ++latestRequestId;
+
     {
-        wait(-1); // Wait for notify()
+        const juce::ScopedLock sl(lock);
 
-        juce::String body;
-        {
-            const juce::ScopedLock sl(lock);
-            if (!shouldSend) continue;
-            shouldSend = false;
+        // whatever is already on its way was asked before this, so its answer is out of date
+        for (auto* job : runningJobs)
+            job->signalJobShouldExit();
 
-            // Create request body from full history
-            body = createRequestBody();
+        if (pendingJob != nullptr)
+        {
+            pendingJob->coalesce(requestId, userMessage, attachment);
         }
+        else
+        {
+            pendingJob = new RequestJob(*this, requestId, userMessage, attachment);
+            pool.addJob(pendingJob, true);
+        }
+    }
 
-        juce::URL url(apiURL);
-        juce::URL urlWithPostData = url.withPOSTData(body);
+    postStatus(requestId, RequestStatus::queued);
+}
 
-        juce::StringPairArray headers;
-        headers.set("Content-Type", "application/json");
-        headers.set("Authorization", "Bearer " + apiKey);
+void ChatGPTClient::cancelRequests()
+{
+    // nothing from the requests so far is delivered any more
+    ++latestRequestId;
 
-        juce::StringArray headerLines;
-        for (int i = 0; i < headers.size(); ++i)
-            headerLines.add(headers.getAllKeys()[i] + ": " + headers.getAllValues()[i]);
-        juce::String headerString = headerLines.joinIntoString("\r\n");
+    const juce::ScopedLock sl(lock);
 
-        juce::URL::InputStreamOptions options =
-            juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inPostData)
-                .withHttpRequestCmd("POST")
-                .withExtraHeaders(headerString)
-                .withConnectionTimeoutMs(10000);
+    if (pendingJob != nullptr)
+        pendingJob->signalJobShouldExit();
 
-        std::unique_ptr<juce::InputStream> stream = urlWithPostData.createInputStream(options);
+    for (auto* job : runningJobs)
+        job->signalJobShouldExit();
 
-        if (stream)
-        {
-            juce::String responseString = stream->readEntireStreamAsString();
+    pendingJob = nullptr;
+}
 
-            juce::var json = juce::JSON::parse(responseString);
-            if (json.isObject())
-            {
-                juce::var choices = json["choices"];
-                if (choices.isArray() && choices[0]["message"]["content"].isString())
-                {
-                    auto reply = choices[0]["message"]["content"].toString().trim();
-
-                    {
-                        const juce::ScopedLock sl(lock);
-                        juce::DynamicObject::Ptr assistantMsg = new juce::DynamicObject();
-                        assistantMsg->setProperty("role", "assistant");
-                        assistantMsg->setProperty("content", reply);
-                        messageHistory.add(juce::var(assistantMsg.get()));
-                    }
-
-                    if (onResponse)
-                        juce::MessageManager::callAsync([this, reply]() { onResponse(reply); });
-                }
-            }
-        }
-    }
+void ChatGPTClient::addLocalExchange(const juce::String& userMessage, const juce::String& reply)
+{
+    const juce::ScopedLock sl(lock);
+    context.addUserTurn(userMessage, {});
+    context.addAssistantReply(reply);
 }
 
-juce::String ChatGPTClient::createRequestBody()
+void ChatGPTClient::clearHistory()
 {
-    juce::DynamicObject::Ptr root = new juce::DynamicObject();
-    root->setProperty("model", "gpt-3.5-turbo");
-    root->setProperty("messages", juce::var(messageHistory));
-    return juce::JSON::toString(juce::var(root.get()));
+    const juce::ScopedLock sl(lock);
+    context.clearTurns();
+}
+
+void ChatGPTClient::resetConversation(const juce::String& systemPrompt)
+{
+    const juce::ScopedLock sl(lock);
+    context.reset(systemPrompt);
+}
+
+ConversationContext::RequestStats ChatGPTClient::getLastRequestStats() const
+{
+    const juce::ScopedLock sl(lock);
+    return lastRequestStats;
+}
+
+ChatGPTClient::RequestMetrics ChatGPTClient::getLastRequestMetrics() const
+{
+    const juce::ScopedLock sl(lock);
+    return lastRequestMetrics;
+}
+
+void ChatGPTClient::postToMessageThread(int requestId, std::function<void(ChatGPTClient&)> callback)
+{
+    juce::MessageManager::callAsync([client = juce::WeakReference<ChatGPTClient>(this), requestId, callback = std::move(callback)]()
+    {
+        if (client != nullptr && client->latestRequestId == requestId)
+            callback(*client);
+    });
+}
+
+void ChatGPTClient::postStatus(int requestId, RequestStatus status, const juce::String& detail)
+{
+    postToMessageThread(requestId, [status, detail](ChatGPTClient& client)
+    {
+        if (client.onRequestStatus)
+            client.onRequestStatus(status, detail);
+    });
 }
@@ -12,32 +12,118 @@
 
 #include <juce_core/juce_core.h>
 #include <JuceHeader.h>
+#include "StreamingResponseParser.h"
+#include "LLMBackend.h"
+#include "ConversationContext.h"
+#include <atomic>
 
 
-class ChatGPTClient : public juce::Thread
+/*
+ Sends the chat to the model, one request per answer.
+
+ Requests run as jobs on a small pool of threads owned by the client, so nothing outlives it.
+ Messages sent in quick succession (or while a request is still waiting to go out) are
+ coalesced into a single request. A new message supersedes a request that is already on
+ its way: that one is cancelled, its prompt stays in the conversation, and its reply is
+ never applied. Every callback only ever reports on the newest request.
+ */
+class ChatGPTClient
 {
 public:
     ChatGPTClient();
-    ~ChatGPTClient() override;
+    ~ChatGPTClient();
+
+    // 'attachment' is only sent along with this message, later ones replace it (e.g. the plugin state)
+    void sendMessageAsync(const juce::String& userMessage, const juce::String& attachment = {});
+
+    // drops anything waiting and cancels anything on its way, e.g. when the answer came from elsewhere
+    void cancelRequests();
 
-    void sendMessageAsync(const juce::String& userMessage);
     void clearHistory();
     void resetConversation(const juce::String& systemPrompt = {});
-    
+
+    // an answer given without asking the model (e.g. from the cache), kept so the conversation still reads right
+    void addLocalExchange(const juce::String& userMessage, const juce::String& reply);
+
+    // what the conversation starts with, before the plugin adds its parameter schema
+    static juce::String getDefaultSystemPrompt();
+
+    // asks for replies matching this JSON schema where the backend supports structured output, void for free text
+    void setResponseSchema(const juce::var& schema);
+
+    // takes effect from the next request
+    void setBackend(std::shared_ptr<LLMBackend> newBackend);
+    juce::String getBackendName() const;
+
+    // the estimated size of the last request that was sent
+    ConversationContext::RequestStats getLastRequestStats() const;
+
+    struct RequestMetrics
+    {
+        int statusCode = 0;
+        int numAttempts = 0;
+        size_t bytesSent = 0, bytesReceived = 0;
+
+        // from the first attempt going out: until the response headers (the connection, any retries and
+        // the request itself), until the first byte of the body, and until the reply was complete.
+        // WebInputStream doesn't say when it has connected, so DNS, TCP and TLS setup can't be timed
+        // on their own and are part of headersMs.
+        double headersMs = 0, firstByteMs = 0, totalMs = 0;
+    };
+
+    // how the last request that got an answer (or gave up) went
+    RequestMetrics getLastRequestMetrics() const;
+
+    enum class RequestStatus
+    {
+        queued,         // waiting for more messages to coalesce, or for a free connection
+        sending,
+        receiving,
+        finished,
+        failed
+    };
+
+    // 'detail' says why a request is waiting (a retry) or failed
+    std::function<void(RequestStatus status, const juce::String& detail)> onRequestStatus;
+
     std::function<void(const juce::String& response)> onResponse;
 
+    // called on the message thread while a reply streams in, before onResponse: the explanation
+    // text as it arrives, and each parameter object as soon as it is complete
+    std::function<void(const juce::String& text)> onResponseText;
+    std::function<void(const ReplyParameter& parameter)> onParameter;
+
 private:
-    void run() override;
+    class RequestJob;
+    friend class RequestJob;
+
+    // how long a message waits for the next one before it goes out
+    static constexpr int coalesceTimeMs = 250;
 
-    juce::String apiKey;
-    juce::String apiURL;
-    juce::String latestUserMessage;
-    juce::Array<juce::var> messageHistory;
+    // one request on its way, plus one that was cancelled but hasn't noticed yet
+    static constexpr int numWorkers = 2;
+
+    std::shared_ptr<LLMBackend> backend;
+    ConversationContext context;
+    juce::var responseSchema;
+    ConversationContext::RequestStats lastRequestStats;
+    RequestMetrics lastRequestMetrics;
 
     juce::CriticalSection lock;
-    bool shouldSend = false;
 
-    juce::String loadApiKeyFromConfig();
-    juce::String createRequestBody();
-    
+    // the job that hasn't gone out yet, which new messages are added to
+    RequestJob* pendingJob = nullptr;
+    juce::Array<RequestJob*> runningJobs;
+
+    // only the newest request's callbacks are delivered
+    std::atomic<int> latestRequestId { 0 };
+
+    // runs 'callback' on the message thread, if this client and 'requestId' are both still current by then
+    void postToMessageThread(int requestId, std::function<void(ChatGPTClient&)> callback);
+    void postStatus(int requestId, RequestStatus status, const juce::String& detail = {});
+
+    JUCE_DECLARE_WEAK_REFERENCEABLE(ChatGPTClient)
+
+    // last, so it is the first to go and waits for its jobs while everything they use still exists
+    juce::ThreadPool pool { numWorkers };
 };
@@ -0,0 +1,176 @@
+/*
+  ==============================================================================
+
+    ConversationContext.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "ConversationContext.h"
+#include <algorithm>
+
+void ConversationContext::reset(const juce::String& newSystemPrompt)
+{
+    systemPrompt = newSystemPrompt;
+    systemPromptTokens = systemPrompt.isNotEmpty() ? estimateTokens(systemPrompt) + tokensPerMessage : 0;
+    turns.clear();
+}
+
+void ConversationContext::clearTurns()
+{
+    turns.clear();
+}
+
+void ConversationContext::addUserTurn(const juce::String& text, const juce::String& attachment)
+{
+    Turn turn;
+    turn.fromUser = true;
+    turn.text = text;
+    turn.attachment = attachment;
+    turn.tokens = estimateTokens(text) + tokensPerMessage;
+    turn.attachmentTokens = estimateTokens(attachment);
+
+    turns.push_back(std::move(turn));
+
+    while( turns.size() > maxStoredTurns )
+        turns.pop_front();
+}
+
+void ConversationContext::addAssistantReply(const juce::String& reply)
+{
+    Turn turn;
+    turn.fromUser = false;
+    turn.text = removeParameterBlocks(reply);
+    turn.tokens = estimateTokens(turn.text) + tokensPerMessage;
+
+    turns.push_back(std::move(turn));
+
+    while( turns.size() > maxStoredTurns )
+        turns.pop_front();
+}
+
+juce::Array<juce::var> ConversationContext::buildMessages(int tokenBudget, RequestStats& stats) const
+{
+    stats = {};
+
+    juce::Array<juce::var> messages;
+    if( systemPrompt.isNotEmpty() )
+        messages.add(makeMessage("system", systemPrompt));
+
+    // the newest user turn, with its attachment, goes in whatever the budget says
+    auto newest = std::find_if(turns.rbegin(), turns.rend(), [](const Turn& turn) { return turn.fromUser; });
+
+    auto used = systemPromptTokens;
+    if( newest != turns.rend() )
+        used += newest->tokens + newest->attachmentTokens;
+
+    // then as many of the turns before it as fit, newest first
+    auto firstSent = newest != turns.rend() ? std::next(newest) : turns.rbegin();
+    for( ; firstSent != turns.rend(); ++firstSent )
+    {
+        if( used + firstSent->tokens > tokenBudget )
+            break;
+
+        used += firstSent->tokens;
+        stats.historyTokens += firstSent->tokens;
+    }
+
+    // the prompts that didn't make it, as a short note rather than nothing at all
+    juce::StringArray droppedPrompts;
+    for( auto turn = firstSent; turn != turns.rend(); ++turn )
+    {
+        ++stats.numTurnsDropped;
+        if( turn->fromUser )
+            droppedPrompts.insert(0, turn->text.substring(0, 80));
+    }
+
+    if( ! droppedPrompts.isEmpty() )
+    {
+        auto note = "Earlier in this conversation the user also asked for: " + droppedPrompts.joinIntoString("; ");
+        auto noteTokens = estimateTokens(note) + tokensPerMessage;
+
+        if( used + noteTokens <= tokenBudget )
+        {
+            messages.add(makeMessage("system", note));
+            used += noteTokens;
+            stats.historyTokens += noteTokens;
+        }
+    }
+
+    // oldest first, the way they happened
+    for( auto turn = firstSent.base(); turn != turns.end(); ++turn )
+    {
+        const bool isNewest = newest != turns.rend() && &*turn == &*newest;
+        auto content = isNewest && turn->attachment.isNotEmpty() ? turn->text + "\n\n" + turn->attachment : turn->text;
+
+        messages.add(makeMessage(turn->fromUser ? "user" : "assistant", content));
+        ++stats.numTurnsSent;
+    }
+
+    stats.totalTokens = used;
+    return messages;
+}
+
+int ConversationContext::estimateTokens(const juce::String& text)
+{
+    // BPE tokenizers average about four characters a token on English, a little less on JSON,
+    // and never manage fewer tokens than there are words and punctuation runs
+    int numWords = 0, numPunctuation = 0;
+    bool inWord = false;
+
+    for( auto c : text )
+    {
+        if( juce::CharacterFunctions::isLetterOrDigit(c) )
+        {
+            numWords += inWord ? 0 : 1;
+            inWord = true;
+            continue;
+        }
+
+        inWord = false;
+        if( ! juce::CharacterFunctions::isWhitespace(c) )
+            ++numPunctuation;
+    }
+
+    return juce::jmax((text.length() + 3) / 4, numWords + numPunctuation / 2);
+}
+
+juce::String ConversationContext::removeParameterBlocks(const juce::String& reply)
+{
+    // a structured output reply is all JSON, and only its explanation is worth keeping
+    if( reply.trimStart().startsWithChar('{') )
+    {
+        auto explanation = juce::JSON::parse(reply)["explanation"];
+        if( explanation.isString() )
+            return ("[settings applied] " + explanation.toString()).trim();
+    }
+
+    juce::String result;
+    int position = 0;
+
+    for( ;; )
+    {
+        auto start = reply.indexOf(position, "```");
+        if( start < 0 )
+            break;
+
+        auto end = reply.indexOf(start + 3, "```");
+        if( end < 0 )
+            break;
+
+        result << reply.substring(position, start) << "[settings applied]";
+        position = end + 3;
+    }
+
+    result << reply.substring(position);
+    return result.trim();
+}
+
+juce::var ConversationContext::makeMessage(const juce::String& role, const juce::String& content)
+{
+    juce::DynamicObject::Ptr message = new juce::DynamicObject();
+    message->setProperty("role", role);
+    message->setProperty("content", content);
+    return juce::var(message.get());
+}
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    ConversationContext.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <deque>
+
+/**
+ The conversation as it's sent to the model, kept inside a token budget.
+
+ Each user turn is the user's own text plus an attachment: the plugin state and instructions
+ that went with it. Only the newest turn's attachment is ever sent, since every later turn
+ carries a fresher state. Assistant replies are sent without their JSON blocks for the same
+ reason. The system prompt and the newest turn always go in. Older turns are added newest
+ first until the budget is used up, and the prompts of any that don't fit are folded into a
+ one line note.
+
+ Token counts are estimated locally, which is close enough to budget with but won't match
+ the service's own count exactly.
+ */
+struct ConversationContext
+{
+    struct RequestStats
+    {
+        int totalTokens = 0;
+        int historyTokens = 0;      // everything except the system prompt and the newest turn
+        int numTurnsSent = 0;
+        int numTurnsDropped = 0;
+    };
+
+    void reset(const juce::String& newSystemPrompt);
+    void clearTurns();
+
+    void addUserTurn(const juce::String& text, const juce::String& attachment);
+    void addAssistantReply(const juce::String& reply);
+
+    /** the "messages" array for the next request, within 'tokenBudget' wherever that's possible */
+    juce::Array<juce::var> buildMessages(int tokenBudget, RequestStats& stats) const;
+
+    static int estimateTokens(const juce::String& text);
+
+    /** a reply with its fenced JSON blocks (or all of a bare JSON reply but its explanation) replaced by a short note */
+    static juce::String removeParameterBlocks(const juce::String& reply);
+private:
+    struct Turn
+    {
+        bool fromUser = true;
+        juce::String text, attachment;
+        int tokens = 0, attachmentTokens = 0;
+    };
+
+    // older turns than this are forgotten altogether, whatever the budget
+    static constexpr size_t maxStoredTurns = 64;
+
+    // what each message costs on top of its content
+    static constexpr int tokensPerMessage = 4;
+
+    juce::String systemPrompt;
+    int systemPromptTokens = 0;
+    std::deque<Turn> turns;
+
+    static juce::var makeMessage(const juce::String& role, const juce::String& content);
+};
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    GenrePresets.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "GenrePresets.h"
+#include "PromptCache.h"
+#include "BinaryData.h"
+
+GenrePresetLibrary::GenrePresetLibrary(const PromptParameterEncoding& encoding)
+{
+    auto json = juce::JSON::parse(juce::String::fromUTF8(BinaryData::GenrePresets_json, BinaryData::GenrePresets_jsonSize));
+    auto* entries = json["presets"].getArray();
+    jassert(entries != nullptr);
+
+    if( entries == nullptr )
+        return;
+
+    std::vector<juce::StringArray> termsPerPreset;
+
+    for( const auto& entry : *entries )
+    {
+        Preset preset;
+        preset.name = entry["name"].toString();
+
+        // the values use the same short keys as the prompts do
+        if( auto* values = entry["set"].getDynamicObject() )
+        {
+            for( const auto& value : values->getProperties() )
+            {
+                juce::DynamicObject::Ptr parameter = new juce::DynamicObject();
+                parameter->setProperty("id", value.name.toString());
+                parameter->setProperty("v", value.value);
+
+                auto decoded = encoding.decode(ReplyParameter::fromVar(juce::var(parameter.get())));
+                jassert(decoded.problem.isEmpty()); // a key the encoding doesn't know, or a value out of range
+
+                if( decoded.isValid() )
+                    preset.preset.set(decoded.parameterIndex, decoded.value);
+            }
+        }
+
+        juce::StringArray terms = getTerms(preset.name);
+        if( auto* tags = entry["tags"].getArray() )
+            for( const auto& tag : *tags )
+                terms.addArray(getTerms(tag.toString()));
+
+        terms.removeDuplicates(false);
+
+        presets.push_back(std::move(preset));
+        termsPerPreset.push_back(std::move(terms));
+    }
+
+    // each term weighs as much as it is rare
+    std::map<juce::String, int> numPresetsWithTerm;
+    for( const auto& terms : termsPerPreset )
+        for( const auto& term : terms )
+            ++numPresetsWithTerm[term];
+
+    for( size_t preset = 0; preset < presets.size(); ++preset )
+    {
+        float sumOfSquares = 0;
+
+        for( const auto& term : termsPerPreset[preset] )
+        {
+            auto weight = std::log(1.f + (float)presets.size() / (float)numPresetsWithTerm[term]);
+            index[term].push_back({ static_cast<int>(preset), weight });
+            sumOfSquares += weight * weight;
+        }
+
+        presets[preset].norm = std::sqrt(sumOfSquares);
+    }
+}
+
+std::optional<GenrePresetLibrary::Match> GenrePresetLibrary::find(const juce::String& prompt) const
+{
+    auto terms = getTerms(prompt);
+    terms.removeDuplicates(false);
+
+    // only the words the library knows count, so a long prompt isn't penalised for its other words
+    std::vector<float> dotProducts(presets.size(), 0.f);
+    float querySumOfSquares = 0;
+
+    for( const auto& term : terms )
+    {
+        auto postings = index.find(term);
+        if( postings == index.end() )
+            continue;
+
+        for( const auto& posting : postings->second )
+            dotProducts[(size_t)posting.preset] += posting.weight * posting.weight;
+
+        // every posting of a term has the same weight
+        querySumOfSquares += postings->second.front().weight * postings->second.front().weight;
+    }
+
+    if( querySumOfSquares <= 0 )
+        return {};
+
+    int best = -1;
+    float bestScore = minScore;
+
+    for( size_t preset = 0; preset < presets.size(); ++preset )
+    {
+        if( dotProducts[preset] <= 0 || presets[preset].norm <= 0 )
+            continue;
+
+        auto score = dotProducts[preset] / (std::sqrt(querySumOfSquares) * presets[preset].norm);
+        if( score >= bestScore )
+        {
+            best = static_cast<int>(preset);
+            bestScore = score;
+        }
+    }
+
+    if( best < 0 )
+        return {};
+
+    Match match;
+    match.name = presets[(size_t)best].name;
+    match.preset = presets[(size_t)best].preset;
+    match.score = bestScore;
+    return match;
+}
+
+juce::StringArray GenrePresetLibrary::getTerms(const juce::String& text)
+{
+    // words that say nothing about the style, which would otherwise pair "sound" with "wall of sound"
+    static const juce::StringArray ignoredWords { "a", "an", "and", "the", "of", "to", "it", "its", "my", "me", "i",
+                                                  "some", "more", "less", "bit", "little", "make", "give", "want",
+                                                  "like", "sound", "sounds", "sounding", "feel", "style", "mix",
+                                                  "track", "song", "please", "can", "you", "with", "for", "in",
+                                                  "on", "this", "that" };
+
+    juce::StringArray words;
+    for( const auto& word : juce::StringArray::fromTokens(PromptPresetCache::normalisePrompt(text), " ", {}) )
+        if( ! ignoredWords.contains(word) )
+            words.add(word);
+
+    juce::StringArray terms;
+    for( int word = 0; word < words.size(); ++word )
+    {
+        terms.add(stem(words[word]));
+
+        if( word > 0 )
+            terms.add(stem(words[word - 1]) + " " + stem(words[word]));
+    }
+
+    return terms;
+}
+
+juce::String GenrePresetLibrary::stem(const juce::String& word)
+{
+    // just enough that "vocals" finds "vocal" and "warmer" finds "warm"
+    if( word.length() > 5 && word.endsWith("er") )
+        return word.dropLastCharacters(2);
+
+    if( word.length() > 3 && word.endsWith("s") && ! word.endsWith("ss") )
+        return word.dropLastCharacters(1);
+
+    return word;
+}
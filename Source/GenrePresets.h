@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    GenrePresets.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "PromptEncoding.h"
+#include <map>
+#include <optional>
+#include <vector>
+
+/**
+ The built in genre and style presets (GenrePresets.json in BinaryData), for an answer that
+ doesn't need the network. Each preset is tagged with genre, artist and style keywords, and a
+ prompt is matched to them by the cosine similarity of their keyword vectors, weighted by
+ how rare each keyword is. Words and the word pairs in a tag both count, so "boom bap" can
+ win over a preset that only mentions "boom".
+
+ Everything is built once, up front: a lookup is a walk of the prompt's handful of words
+ through an inverted index.
+ */
+class GenrePresetLibrary
+{
+public:
+    explicit GenrePresetLibrary(const PromptParameterEncoding& encoding);
+
+    struct Match
+    {
+        juce::String name;
+        ParameterPreset preset;
+        float score = 0;
+    };
+
+    /** the preset that fits 'prompt' best, if any fits it well enough */
+    std::optional<Match> find(const juce::String& prompt) const;
+
+    int getNumPresets() const { return static_cast<int>(presets.size()); }
+private:
+    // below this the prompt shares little more than a common word with the preset
+    static constexpr float minScore = 0.25f;
+
+    struct Preset
+    {
+        juce::String name;
+        ParameterPreset preset;
+        float norm = 0;
+    };
+
+    struct Posting
+    {
+        int preset;
+        float weight;
+    };
+
+    std::vector<Preset> presets;
+    std::map<juce::String, std::vector<Posting>> index;
+
+    static juce::StringArray getTerms(const juce::String& text);
+    static juce::String stem(const juce::String& word);
+};
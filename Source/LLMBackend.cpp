@@ -0,0 +1,246 @@
+/*
+  ==============================================================================
+
+    LLMBackend.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "LLMBackend.h"
+#include "BinaryData.h"
+
+juce::String LLMBackend::createRequestBody(const juce::Array<juce::var>& messages, const juce::var& responseSchema) const
+{
+    juce::DynamicObject::Ptr root = new juce::DynamicObject();
+    root->setProperty("model", options.model);
+    root->setProperty("messages", juce::var(messages));
+    root->setProperty("stream", true);
+
+    // the reply is then a bare JSON object the service guarantees matches the schema
+    if( options.structuredOutput && responseSchema.isObject() )
+    {
+        juce::DynamicObject::Ptr jsonSchema = new juce::DynamicObject();
+        jsonSchema->setProperty("name", "settings");
+        jsonSchema->setProperty("strict", true);
+        jsonSchema->setProperty("schema", responseSchema);
+
+        juce::DynamicObject::Ptr format = new juce::DynamicObject();
+        format->setProperty("type", "json_schema");
+        format->setProperty("json_schema", juce::var(jsonSchema.get()));
+
+        root->setProperty("response_format", juce::var(format.get()));
+    }
+
+    return juce::JSON::toString(juce::var(root.get()));
+}
+
+LLMBackend::Response LLMBackend::send(const juce::String& body,
+                                     const std::function<bool()>& shouldGiveUp,
+                                     const std::function<void(const juce::String&, int)>& onRetry) const
+{
+    Response response;
+    juce::Random random;
+
+    for( int attempt = 0;; ++attempt )
+    {
+        response.numAttempts = attempt + 1;
+
+        auto stream = std::make_unique<juce::WebInputStream>(juce::URL(options.url).withPOSTData(body), true);
+        stream->withExtraHeaders(getHeaders().joinIntoString("\r\n"))
+               .withConnectionTimeout(options.connectionTimeoutMs);
+
+        // some platforms report an error status as a failed connect, so the status decides
+        stream->connect(nullptr);
+        response.statusCode = stream->getStatusCode();
+
+        if( response.statusCode >= 200 && response.statusCode < 300 )
+        {
+            response.stream = std::move(stream);
+            response.error = {};
+            return response;
+        }
+
+        response.error = describeFailure(response.statusCode, *stream);
+
+        // anything else (a bad key, a bad request) fails the same way however often it's sent
+        const bool isTransient = response.statusCode == 0 || response.statusCode == 429 || response.statusCode >= 500;
+        if( ! isTransient || attempt >= options.maxRetries || shouldGiveUp() )
+            return response;
+
+        // doubling each time, jittered so instances that failed together don't retry together
+        auto delayMs = options.retryDelayMs * (double)(1 << attempt) * (0.5 + random.nextDouble());
+
+        auto retryAfterSeconds = stream->getResponseHeaders()["Retry-After"].getIntValue();
+        if( retryAfterSeconds > 0 )
+            delayMs = juce::jmax(delayMs, retryAfterSeconds * 1000.0);
+
+        delayMs = juce::jmin(delayMs, 30000.0);
+
+        if( onRetry )
+            onRetry(response.error, juce::roundToInt(delayMs));
+
+        for( auto retryTime = juce::Time::getMillisecondCounterHiRes() + delayMs;; )
+        {
+            if( shouldGiveUp() )
+                return response;
+
+            auto remaining = retryTime - juce::Time::getMillisecondCounterHiRes();
+            if( remaining <= 0 )
+                break;
+
+            juce::Thread::sleep(juce::jlimit(1, 50, (int)remaining));
+        }
+    }
+}
+
+juce::String LLMBackend::describeFailure(int statusCode, juce::WebInputStream& stream) const
+{
+    if( statusCode == 0 )
+        return "couldn't connect to " + juce::URL(options.url).getDomain();
+
+    // OpenAI-style services explain themselves as {"error": {"message": "..."}}
+    auto message = juce::JSON::parse(stream.readEntireStreamAsString().substring(0, 4096))["error"]["message"];
+    if( message.isString() && message.toString().isNotEmpty() )
+        return "HTTP " + juce::String(statusCode) + ": " + message.toString();
+
+    return "HTTP " + juce::String(statusCode);
+}
+
+juce::String LLMBackend::getStreamedText(const juce::var& event) const
+{
+    auto text = event["choices"][0]["delta"]["content"];
+    return text.isString() ? text.toString() : juce::String();
+}
+
+juce::String LLMBackend::getCompleteText(const juce::var& reply) const
+{
+    auto text = reply["choices"][0]["message"]["content"];
+    return text.isString() ? text.toString() : juce::String();
+}
+
+juce::StringArray LLMBackend::getHeaders() const
+{
+    return { "Content-Type: application/json", "Authorization: Bearer " + options.apiKey };
+}
+
+LLMBackend::RequestSlot LLMBackend::acquireRequestSlot(const std::function<bool()>& shouldGiveUp) const
+{
+    auto& limiter = getLimiter();
+
+    for( ;; )
+    {
+        {
+            const juce::ScopedLock sl(limiter.lock);
+            if( limiter.inUse < juce::jmax(1, options.maxConcurrentRequests) )
+            {
+                ++limiter.inUse;
+
+                RequestSlot slot;
+                slot.owner = this;
+                return slot;
+            }
+        }
+
+        if( shouldGiveUp() )
+            return {};
+
+        limiter.slotFreed.wait(50);
+    }
+}
+
+LLMBackend::RequestSlot::~RequestSlot()
+{
+    if( owner == nullptr )
+        return;
+
+    auto& limiter = owner->getLimiter();
+    const juce::ScopedLock sl(limiter.lock);
+    --limiter.inUse;
+    limiter.slotFreed.signal();
+}
+
+//==============================================================================
+LLMBackend::RequestLimiter& OpenAIBackend::getLimiter() const
+{
+    static RequestLimiter limiter;
+    return limiter;
+}
+
+juce::StringArray LocalServerBackend::getHeaders() const
+{
+    // llama-server and friends ignore the key, but some are started with one
+    if( options.apiKey.isEmpty() )
+        return { "Content-Type: application/json" };
+
+    return LLMBackend::getHeaders();
+}
+
+LLMBackend::RequestLimiter& LocalServerBackend::getLimiter() const
+{
+    static RequestLimiter limiter;
+    return limiter;
+}
+
+//==============================================================================
+static juce::var getBackendConfig()
+{
+    return juce::JSON::parse(juce::String::fromUTF8(BinaryData::config_json, BinaryData::config_jsonSize));
+}
+
+juce::StringArray getLLMBackendNames()
+{
+    return { "OpenAI", "Local server" };
+}
+
+std::shared_ptr<LLMBackend> makeLLMBackend(LLMBackendType type)
+{
+    auto config = getBackendConfig();
+    auto getString = [&config](const char* key, const juce::String& fallback)
+    {
+        auto value = config.getProperty(key, {});
+        return value.isString() && value.toString().isNotEmpty() ? value.toString() : fallback;
+    };
+
+    LLMBackend::Options options;
+
+    if( type == LLMBackendType::LocalServer )
+    {
+        options.url = getString("local_url", "http://127.0.0.1:8080/v1/chat/completions");
+        options.model = getString("local_model", "local");
+        options.apiKey = getString("local_api_key", {});
+
+        // it's on this machine: if it doesn't answer quickly it isn't running
+        options.connectionTimeoutMs = 2000;
+        options.maxConcurrentRequests = 1;
+        
+        // a refused connection means it isn't running, which waiting won't fix for long
+        options.maxRetries = 1;
+
+        // llama-server turns the schema into a grammar, but older builds ignore it
+        options.structuredOutput = config.getProperty("local_structured_output", false);
+        
+        // llama-server's default 4096 token context, less room for the reply
+        options.contextTokenBudget = 2500;
+
+        return std::make_shared<LocalServerBackend>(options);
+    }
+
+    options.url = getString("openai_url", "https://api.openai.com/v1/chat/completions");
+    options.model = getString("openai_model", "gpt-3.5-turbo");
+    options.apiKey = getString("openai_api_key", {});
+    options.connectionTimeoutMs = 10000;
+    options.maxConcurrentRequests = 4;
+    options.contextTokenBudget = 6000;
+
+    // needs a model that supports json_schema responses, which gpt-3.5-turbo doesn't
+    options.structuredOutput = config.getProperty("openai_structured_output", false);
+
+    return std::make_shared<OpenAIBackend>(options);
+}
+
+LLMBackendType getDefaultLLMBackendType()
+{
+    auto backend = getBackendConfig().getProperty("backend", {}).toString();
+    return backend.equalsIgnoreCase("local") ? LLMBackendType::LocalServer : LLMBackendType::OpenAI;
+}
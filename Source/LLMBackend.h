@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+    LLMBackend.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <memory>
+#include <utility>
+
+/**
+ Everything that differs between the services the chat can talk to: how a request is built,
+ how it's sent, and how the reply is read back. ChatGPTClient drives one request at a time
+ through whichever backend is selected, and can switch backends between requests.
+ */
+struct LLMBackend
+{
+    struct Options
+    {
+        juce::String url, model, apiKey;
+        int connectionTimeoutMs = 10000;
+
+        // requests allowed in flight at once, across every plugin instance using this backend
+        int maxConcurrentRequests = 4;
+        
+        // how much of the model's context the conversation may use, leaving the rest for the reply
+        int contextTokenBudget = 6000;
+        
+        // retries after a 429, a 5xx or a failed connection, the first one after about retryDelayMs
+        int maxRetries = 3;
+        int retryDelayMs = 500;
+
+        // whether requests may ask for replies that match a JSON schema ("response_format")
+        bool structuredOutput = false;
+    };
+
+    explicit LLMBackend(Options backendOptions) : options(std::move(backendOptions)) { }
+    virtual ~LLMBackend() = default;
+
+    virtual juce::String getName() const = 0;
+    const Options& getOptions() const { return options; }
+
+    // request builder, asking for replies matching 'responseSchema' if it's an object and structured output is on
+    virtual juce::String createRequestBody(const juce::Array<juce::var>& messages, const juce::var& responseSchema = {}) const;
+
+    /** what send() got back: the body to read if the request succeeded, otherwise why it didn't */
+    struct Response
+    {
+        std::unique_ptr<juce::WebInputStream> stream;
+        int statusCode = 0;         // 0 if the service couldn't be reached at all
+        int numAttempts = 0;
+        juce::String error;
+
+        bool succeeded() const { return stream != nullptr; }
+    };
+
+    /*
+     transport: posts 'body' and waits for the response headers. Rate limits, server errors and
+     failed connections are retried with jittered exponential backoff (or after the server's
+     Retry-After), calling 'onRetry' before each wait. Gives up early once 'shouldGiveUp' returns true.
+
+     Every attempt opens its own juce::WebInputStream, which can't hand its connection on to the
+     next one. WinINet and NSURLSession may still reuse a connection from their own pools, but
+     JUCE's curl backend on Linux connects afresh every time.
+     */
+    virtual Response send(const juce::String& body,
+                          const std::function<bool()>& shouldGiveUp,
+                          const std::function<void(const juce::String& reason, int delayMs)>& onRetry = nullptr) const;
+
+    // response parser: the text in one streamed event, or in a complete (non-streamed) reply
+    virtual juce::String getStreamedText(const juce::var& event) const;
+    virtual juce::String getCompleteText(const juce::var& reply) const;
+
+    /** holds one of the backend's request slots for as long as it lives */
+    struct RequestSlot
+    {
+        RequestSlot() = default;
+        RequestSlot(RequestSlot&& other) noexcept : owner(std::exchange(other.owner, nullptr)) { }
+        ~RequestSlot();
+
+        bool isValid() const { return owner != nullptr; }
+    private:
+        friend struct LLMBackend;
+        const LLMBackend* owner = nullptr;
+    };
+
+    /** waits for a free slot, giving up (with an invalid slot) once 'shouldGiveUp' returns true */
+    RequestSlot acquireRequestSlot(const std::function<bool()>& shouldGiveUp) const;
+protected:
+    Options options;
+
+    virtual juce::StringArray getHeaders() const;
+
+    // the reason a request failed, from the service's own error message where it sent one
+    virtual juce::String describeFailure(int statusCode, juce::WebInputStream& stream) const;
+
+    struct RequestLimiter
+    {
+        juce::CriticalSection lock;
+        juce::WaitableEvent slotFreed;
+        int inUse = 0;
+    };
+
+    // one per kind of backend, shared by every plugin instance in the process
+    virtual RequestLimiter& getLimiter() const = 0;
+};
+
+/** api.openai.com, or any other hosted endpoint speaking the same chat completions API */
+struct OpenAIBackend : LLMBackend
+{
+    using LLMBackend::LLMBackend;
+
+    juce::String getName() const override { return "OpenAI"; }
+private:
+    RequestLimiter& getLimiter() const override;
+};
+
+/**
+ An OpenAI-compatible server on this machine, e.g. llama.cpp's llama-server. Nothing leaves
+ the computer, no key is needed, and the server only runs one completion at a time.
+ */
+struct LocalServerBackend : LLMBackend
+{
+    using LLMBackend::LLMBackend;
+
+    juce::String getName() const override { return "Local server"; }
+private:
+    juce::StringArray getHeaders() const override;
+    RequestLimiter& getLimiter() const override;
+};
+
+enum class LLMBackendType
+{
+    OpenAI,
+    LocalServer
+};
+
+juce::StringArray getLLMBackendNames();
+
+/*
+ creates a backend with its defaults, overridden by anything in the embedded config.json:
+ "openai_api_key", "openai_url", "openai_model", "openai_structured_output",
+ "local_url", "local_model", "local_structured_output"
+ */
+std::shared_ptr<LLMBackend> makeLLMBackend(LLMBackendType type);
+
+/** the backend config.json asks for with "backend": "openai" or "local", OpenAI otherwise */
+LLMBackendType getDefaultLLMBackendType();
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEQ.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "LinearPhaseEQ.h"
+
+juce::AudioBuffer<float> makeLinearPhaseKernel(const ChainSnapshot& snapshot)
+{
+    const auto size = snapshot.settings.linearPhaseKernelSize;
+    const auto order = juce::roundToInt(std::log2(size));
+    jassert((1 << order) == size);
+
+    juce::dsp::FFT fft(order);
+    std::vector<float> spectrum((size_t)size * 2, 0.f);
+
+    // zero phase: every bin is real and holds the magnitude the IIR EQ has at that frequency
+    for( int bin = 0; bin <= size / 2; ++bin )
+    {
+        auto frequency = bin * snapshot.sampleRate / size;
+        spectrum[(size_t)bin * 2] = (float)getEQMagnitudeForFrequency(snapshot, frequency);
+    }
+
+    fft.performRealOnlyInverseTransform(spectrum.data());
+
+    // the impulse response wraps around sample 0, so rotate it to the middle and window it
+    std::vector<float> window((size_t)size + 1);
+    juce::dsp::WindowingFunction<float>::fillWindowingTables(window.data(),
+                                                             window.size(),
+                                                             juce::dsp::WindowingFunction<float>::blackman,
+                                                             false);
+
+    juce::AudioBuffer<float> kernel(1, size);
+    auto* taps = kernel.getWritePointer(0);
+
+    for( int n = 0; n < size; ++n )
+        taps[n] = spectrum[(size_t)((n + size / 2) % size)] * window[(size_t)n];
+
+    return kernel;
+}
+
+//==============================================================================
+LinearPhaseKernelBuilder::LinearPhaseKernelBuilder(SnapshotSource source, KernelTarget target) :
+juce::Thread("Linear Phase Kernel Builder"),
+getSnapshot(std::move(source)),
+onKernelChanged(std::move(target))
+{
+}
+
+LinearPhaseKernelBuilder::~LinearPhaseKernelBuilder()
+{
+    stopThread(1000);
+}
+
+void LinearPhaseKernelBuilder::run()
+{
+    while( ! threadShouldExit() )
+    {
+        auto snapshot = getSnapshot();
+
+        if( ! hasBuilt || needsNewKernel(snapshot, lastBuilt) )
+        {
+            hasBuilt = true;
+            lastBuilt = snapshot;
+
+            juce::AudioBuffer<float> kernel;
+            if( snapshot.settings.linearPhase )
+                kernel = makeLinearPhaseKernel(snapshot);
+
+            onKernelChanged(snapshot, kernel);
+        }
+
+        wait(-1);
+    }
+}
+
+bool LinearPhaseKernelBuilder::needsNewKernel(const ChainSnapshot& current, const ChainSnapshot& previous)
+{
+    const auto& now = current.settings;
+    const auto& before = previous.settings;
+
+    if( now.linearPhase != before.linearPhase )
+        return true;
+
+    // nothing below matters while the IIR EQ is running
+    if( ! now.linearPhase )
+        return false;
+
+    return now.linearPhaseKernelSize != before.linearPhaseKernelSize
+        || current.sampleRate != previous.sampleRate
+        || now.lowCutBypassed != before.lowCutBypassed
+        || now.peakBypassed != before.peakBypassed
+        || now.highCutBypassed != before.highCutBypassed
+        || current.peak.values != previous.peak.values
+        || current.lowCut.numStages != previous.lowCut.numStages
+        || current.lowCut.stages[0].values != previous.lowCut.stages[0].values
+        || current.highCut.numStages != previous.highCut.numStages
+        || current.highCut.stages[0].values != previous.highCut.stages[0].values;
+}
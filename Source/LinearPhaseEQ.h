@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    LinearPhaseEQ.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <functional>
+#include "ChainSnapshot.h"
+
+// the kernel lengths offered by the "Linear Phase Length" parameter
+constexpr std::array<int, 4> linearPhaseKernelSizes { 1024, 2048, 4096, 8192 };
+
+/*
+ a symmetric FIR with the same magnitude response as the IIR EQ in 'snapshot', centred on
+ sample linearPhaseKernelSize / 2, which is also the delay it adds.
+ */
+juce::AudioBuffer<float> makeLinearPhaseKernel(const ChainSnapshot& snapshot);
+
+/**
+ Checks the published snapshot from its own thread whenever notify() says there's a new one,
+ and redesigns the linear-phase kernel if the EQ part of it has changed. The audio thread never
+ waits on it: the kernel is handed to onKernelChanged, which passes it on to the convolution
+ engines. An empty kernel means linear-phase mode was switched off.
+ */
+struct LinearPhaseKernelBuilder : juce::Thread
+{
+    using SnapshotSource = std::function<ChainSnapshot()>;
+    using KernelTarget = std::function<void(const ChainSnapshot&, const juce::AudioBuffer<float>&)>;
+
+    LinearPhaseKernelBuilder(SnapshotSource source, KernelTarget target);
+    ~LinearPhaseKernelBuilder() override;
+
+    void run() override;
+private:
+    SnapshotSource getSnapshot;
+    KernelTarget onKernelChanged;
+
+    bool hasBuilt = false;
+    ChainSnapshot lastBuilt;
+
+    static bool needsNewKernel(const ChainSnapshot& current, const ChainSnapshot& previous);
+};
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    MultibandCompressor.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+/**
+ A 3 or 4 band compressor. The crossover network splits the whole block into every band
+ in a single pass, using Linkwitz-Riley filters with allpass compensation on the lower bands
+ so that the bands sum back flat. Each band then runs its own juce::dsp::Compressor, and so
+ its own level detector, over its part of the signal.
+
+     3 bands:  low | mid | high                   split at the low and high crossovers
+     4 bands:  low | low mid | high mid | high    split at the low, mid and high crossovers
+ */
+template<typename SampleType>
+struct MultibandCompressor
+{
+    using Block = juce::dsp::AudioBlock<SampleType>;
+
+    static constexpr int maxBands = 4;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        for( auto& filter : splitters )
+            filter.prepare(spec);
+
+        for( auto& filter : allpasses )
+        {
+            filter.setType(juce::dsp::LinkwitzRileyFilterType::allpass);
+            filter.prepare(spec);
+        }
+
+        for( auto& band : bands )
+            band.prepare(spec);
+
+        for( auto& buffer : bandBuffers )
+            buffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+        updateCrossovers();
+    }
+
+    void reset()
+    {
+        for( auto& filter : splitters )
+            filter.reset();
+
+        for( auto& filter : allpasses )
+            filter.reset();
+
+        for( auto& band : bands )
+            band.reset();
+    }
+
+    void setNumBands(int newNumBands)
+    {
+        jassert(newNumBands == 3 || newNumBands == 4);
+        numBands = juce::jlimit(3, maxBands, newNumBands);
+        updateCrossovers();
+    }
+
+    /** 'mid' is only used in 4 band mode */
+    void setCrossoverFrequencies(SampleType low, SampleType mid, SampleType high)
+    {
+        crossovers = { low, mid, high };
+        updateCrossovers();
+    }
+
+    juce::dsp::Compressor<SampleType>& getBand(int band) { return bands[(size_t)band]; }
+
+    void process(Block& block)
+    {
+        const auto maxChunk = (size_t)bandBuffers[0].getNumSamples();
+
+        for( size_t offset = 0; offset < block.getNumSamples(); offset += maxChunk )
+        {
+            auto chunk = block.getSubBlock(offset, juce::jmin(maxChunk, block.getNumSamples() - offset));
+
+            split(chunk);
+
+            chunk.clear();
+
+            for( int band = 0; band < numBands; ++band )
+            {
+                auto bandBlock = getBandBlock(band, chunk);
+                juce::dsp::ProcessContextReplacing<SampleType> context(bandBlock);
+                bands[(size_t)band].process(context);
+
+                chunk.add(bandBlock);
+            }
+        }
+    }
+private:
+    using Filter = juce::dsp::LinkwitzRileyFilter<SampleType>;
+
+    int numBands = 3;
+
+    // as set, before they're put in order for the number of bands
+    std::array<SampleType, 3> crossovers { SampleType(150), SampleType(1500), SampleType(6000) };
+
+    // splitters[0] is the lowest crossover, splitters[2] is only used with 4 bands
+    std::array<Filter, 3> splitters;
+
+    // lowest band: the 2nd and (4 bands) 3rd crossover; second band: the 3rd crossover
+    std::array<Filter, 3> allpasses;
+
+    std::array<juce::dsp::Compressor<SampleType>, maxBands> bands;
+    std::array<juce::AudioBuffer<SampleType>, maxBands> bandBuffers;
+
+    Block getBandBlock(int band, const Block& like)
+    {
+        return Block(bandBuffers[(size_t)band]).getSubsetChannelBlock(0, like.getNumChannels())
+                                               .getSubBlock(0, like.getNumSamples());
+    }
+
+    void updateCrossovers()
+    {
+        // the bands have to stay in order, whatever the parameters say, and with 3 bands the
+        // unused mid crossover mustn't push the high one up
+        const auto low = crossovers[0];
+        const auto mid = juce::jmax(crossovers[1], low);
+        const auto high = juce::jmax(crossovers[2], numBands == 3 ? low : mid);
+        const auto second = numBands == 3 ? high : mid;
+
+        splitters[0].setCutoffFrequency(low);
+        splitters[1].setCutoffFrequency(second);
+        splitters[2].setCutoffFrequency(high);
+
+        allpasses[0].setCutoffFrequency(second);
+        allpasses[1].setCutoffFrequency(high);
+        allpasses[2].setCutoffFrequency(high);
+    }
+
+    void split(const Block& block)
+    {
+        const auto numSamples = block.getNumSamples();
+
+        for( size_t ch = 0; ch < block.getNumChannels(); ++ch )
+        {
+            const auto channel = (int)ch;
+            const auto* input = block.getChannelPointer(ch);
+
+            std::array<SampleType*, maxBands> outputs;
+            for( int band = 0; band < maxBands; ++band )
+                outputs[(size_t)band] = bandBuffers[(size_t)band].getWritePointer(channel);
+
+            if( numBands == 3 )
+            {
+                for( size_t i = 0; i < numSamples; ++i )
+                {
+                    SampleType low, rest;
+                    splitters[0].processSample(channel, input[i], low, rest);
+                    splitters[1].processSample(channel, rest, outputs[1][i], outputs[2][i]);
+                    outputs[0][i] = allpasses[0].processSample(channel, low);
+                }
+            }
+            else
+            {
+                for( size_t i = 0; i < numSamples; ++i )
+                {
+                    SampleType low, rest, mid, upper;
+                    splitters[0].processSample(channel, input[i], low, rest);
+                    splitters[1].processSample(channel, rest, mid, upper);
+                    splitters[2].processSample(channel, upper, outputs[2][i], outputs[3][i]);
+                    outputs[0][i] = allpasses[1].processSample(channel, allpasses[0].processSample(channel, low));
+                    outputs[1][i] = allpasses[2].processSample(channel, mid);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,113 @@
+/*
+  ==============================================================================
+
+    ParameterHistory.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <vector>
+
+/**
+ Undo/redo for parameter changes. Each entry is a sparse diff, holding only the parameters
+ that moved, along with what caused it (the chat prompt for an AI turn). The entries live
+ in a fixed ring, so the oldest ones are dropped once it's full and a long session can't
+ keep growing it.
+ */
+struct ParameterHistory
+{
+    static constexpr int capacity = 64;
+
+    struct Change
+    {
+        juce::uint16 index;
+        float before, after;
+    };
+
+    struct Entry
+    {
+        std::vector<Change> changes;
+        juce::String description;
+    };
+
+    /** adds 'entry' as the newest step and forgets anything that could have been redone */
+    void push(Entry entry)
+    {
+        if( entry.changes.empty() )
+            return;
+
+        if( numUndoable == capacity )
+        {
+            oldest = (oldest + 1) % capacity;
+            --numUndoable;
+        }
+
+        at(numUndoable) = std::move(entry);
+        ++numUndoable;
+        numRedoable = 0;
+    }
+
+    /** the entry to revert (apply every 'before'), or nullptr if there's nothing to undo */
+    const Entry* undo()
+    {
+        if( numUndoable == 0 )
+            return nullptr;
+
+        --numUndoable;
+        ++numRedoable;
+        return &at(numUndoable);
+    }
+
+    /** the entry to apply again (every 'after'), or nullptr if there's nothing to redo */
+    const Entry* redo()
+    {
+        if( numRedoable == 0 )
+            return nullptr;
+
+        --numRedoable;
+        return &at(numUndoable++);
+    }
+
+    /** adds the changes in 'from' to 'into', keeping the oldest 'before' of any parameter in both */
+    static void merge(Entry& into, const Entry& from)
+    {
+        for( const auto& change : from.changes )
+        {
+            auto existing = std::find_if(into.changes.begin(), into.changes.end(),
+                                         [&change](const Change& c) { return c.index == change.index; });
+
+            if( existing != into.changes.end() )
+                existing->after = change.after;
+            else
+                into.changes.push_back(change);
+        }
+    }
+
+    bool canUndo() const { return numUndoable > 0; }
+    bool canRedo() const { return numRedoable > 0; }
+
+    juce::String getUndoDescription() const { return canUndo() ? at(numUndoable - 1).description : juce::String(); }
+    juce::String getRedoDescription() const { return canRedo() ? at(numUndoable).description : juce::String(); }
+
+    void clear()
+    {
+        for( auto& entry : entries )
+            entry = {};
+
+        oldest = numUndoable = numRedoable = 0;
+    }
+private:
+    std::array<Entry, capacity> entries;
+
+    // entries[oldest] is the oldest undoable step, the redoable ones follow the undoable ones
+    int oldest = 0, numUndoable = 0, numRedoable = 0;
+
+    Entry& at(int position) { return entries[(size_t)((oldest + position) % capacity)]; }
+    const Entry& at(int position) const { return entries[(size_t)((oldest + position) % capacity)]; }
+};
@@ -233,26 +233,11 @@ audioProcessor(p),
 leftPathProducer(audioProcessor.leftChannelFifo),
 rightPathProducer(audioProcessor.rightChannelFifo)
 {
-    const auto& params = audioProcessor.getParameters();
-    for( auto param : params )
-    {
-        param->addListener(this);
-    }
-
     updateChain();
     
     startTimerHz(60);
 }
 
-ResponseCurveComponent::~ResponseCurveComponent()
-{
-    const auto& params = audioProcessor.getParameters();
-    for( auto param : params )
-    {
-        param->removeListener(this);
-    }
-}
-
 void ResponseCurveComponent::updateResponseCurve()
 {
     using namespace juce;
@@ -260,49 +245,14 @@ void ResponseCurveComponent::updateResponseCurve()
     
     auto w = responseArea.getWidth();
     
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
-    
-    auto sampleRate = audioProcessor.getSampleRate();
-    
     std::vector<double> mags;
     
     mags.resize(w);
     
     for( int i = 0; i < w; ++i )
     {
-        double mag = 1.f;
         auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-        
-        if(! monoChain.isBypassed<ChainPositions::Peak>() )
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        
-        if( !monoChain.isBypassed<ChainPositions::LowCut>() )
-        {
-            if( !lowcut.isBypassed<0>() )
-                mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !lowcut.isBypassed<1>() )
-                mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !lowcut.isBypassed<2>() )
-                mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !lowcut.isBypassed<3>() )
-                mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-        
-        if( !monoChain.isBypassed<ChainPositions::HighCut>() )
-        {
-            if( !highcut.isBypassed<0>() )
-                mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !highcut.isBypassed<1>() )
-                mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !highcut.isBypassed<2>() )
-                mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-            if( !highcut.isBypassed<3>() )
-                mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, sampleRate);
-        }
-            
-        mags[i] = Decibels::gainToDecibels(mag);
+        mags[i] = Decibels::gainToDecibels(getEQMagnitudeForFrequency(snapshot, freq));
     }
     
     responseCurve.clear();
@@ -516,11 +466,6 @@ void ResponseCurveComponent::resized()
     updateResponseCurve();
 }
 
-void ResponseCurveComponent::parameterValueChanged(int parameterIndex, float newValue)
-{
-    parametersChanged.set(true);
-}
-
 void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
     juce::AudioBuffer<float> tempIncomingBuffer;
@@ -571,7 +516,10 @@ void ResponseCurveComponent::timerCallback()
         rightPathProducer.process(fftBounds, sampleRate);
     }
 
-    if( parametersChanged.compareAndSetBool(false, true) )
+    // keeps the curve live while the host isn't calling processBlock
+    audioProcessor.publishSettingsIfChanged();
+    
+    if( audioProcessor.getChainSnapshot().generation != snapshot.generation )
     {
         updateChain();
         updateResponseCurve();
@@ -582,25 +530,8 @@ void ResponseCurveComponent::timerCallback()
 
 void ResponseCurveComponent::updateChain()
 {
-    auto chainSettings = getChainSettings(audioProcessor.apvts);
-    
-    monoChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    monoChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    monoChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    
-    auto peakCoefficients = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-    
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(),
-                    lowCutCoefficients,
-                    chainSettings.lowCutSlope);
-    
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(),
-                    highCutCoefficients,
-                    chainSettings.highCutSlope);
+    // the processor already designed these coefficients, we only need a consistent copy
+    snapshot = audioProcessor.getChainSnapshot();
 }
 
 juce::Rectangle<int> ResponseCurveComponent::getRenderArea()
@@ -736,6 +667,102 @@ analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyz
 
 
     
+    updateAnalyzerTapSelectors();
+    
+    // the host can change the bus layout while the editor is open
+    startTimerHz(4);
+    
+    for( int slot = 0; slot < SimpleEQAudioProcessor::numSnapshotSlots; ++slot )
+    {
+        auto& button = snapshotSlotButtons[(size_t)slot];
+        button.setButtonText(juce::String::charToString(juce::juce_wchar('A' + slot)));
+        button.setClickingTogglesState(false);
+        button.onClick = [this, slot]()
+        {
+            if( audioProcessor.isSnapshotSlotStored(slot) )
+                audioProcessor.recallSnapshotSlot(slot);
+            else
+                audioProcessor.storeSnapshotSlot(slot);
+            
+            updateSnapshotSlotButtons();
+        };
+        
+        addAndMakeVisible(button);
+    }
+    
+    storeSnapshotButton.onClick = [this]()
+    {
+        audioProcessor.storeSnapshotSlot(audioProcessor.getActiveSnapshotSlot());
+        updateSnapshotSlotButtons();
+    };
+    
+    addAndMakeVisible(storeSnapshotButton);
+    updateSnapshotSlotButtons();
+    
+    undoButton.onClick = [this]()
+    {
+        auto description = audioProcessor.getUndoDescription();
+        if( audioProcessor.undo() )
+            chatBox.appendMessage("Undo", description);
+    };
+    
+    redoButton.onClick = [this]()
+    {
+        auto description = audioProcessor.getRedoDescription();
+        if( audioProcessor.redo() )
+            chatBox.appendMessage("Redo", description);
+    };
+    
+    addAndMakeVisible(undoButton);
+    addAndMakeVisible(redoButton);
+    
+    moreButton.onClick = [this]()
+    {
+        juce::CallOutBox::launchAsynchronously(std::make_unique<AdvancedControlsComponent>(audioProcessor.apvts),
+                                               moreButton.getBounds(), this);
+    };
+    
+    addAndMakeVisible(moreButton);
+    
+    backendSelector.addItemList(getLLMBackendNames(), 1);
+    backendSelector.setText(chatClient.getBackendName(), juce::dontSendNotification);
+    backendSelector.onChange = [this]()
+    {
+        if( backendSelector.getSelectedItemIndex() >= 0 )
+            chatClient.setBackend(makeLLMBackend(static_cast<LLMBackendType>(backendSelector.getSelectedItemIndex())));
+    };
+    
+    addAndMakeVisible(backendSelector);
+    
+    candidateCountSelector.addItem("One answer", 1);
+    for( int count = 2; count <= CandidateAudition::maxCandidates; ++count )
+        candidateCountSelector.addItem(juce::String(count) + " options", count);
+    candidateCountSelector.setSelectedId(1, juce::dontSendNotification);
+    addAndMakeVisible(candidateCountSelector);
+    
+    for( int candidate = 0; candidate < CandidateAudition::maxCandidates; ++candidate )
+    {
+        auto& button = candidateButtons[(size_t)candidate];
+        button.setButtonText(juce::String(candidate + 1));
+        button.onClick = [this, candidate]() { auditionCandidate(candidate); };
+        addAndMakeVisible(button);
+    }
+    
+    liveButton.onClick = [this]() { auditionCandidate(-1); };
+    keepCandidateButton.onClick = [this]() { keepCandidate(); };
+    addAndMakeVisible(liveButton);
+    addAndMakeVisible(keepCandidateButton);
+    
+    previewRenderer.onPreviewReady = [this](int candidate)
+    {
+        if( juce::isPositiveAndBelow(candidate, (int)candidates.size()) )
+            candidates[(size_t)candidate].previewReady = true;
+        
+        updateCandidateButtons();
+    };
+    
+    updateCandidateButtons();
+    
     for( auto* comp : getComps() )
     {
         addAndMakeVisible(comp);
@@ -843,86 +870,139 @@ analyzerEnabledButtonAttachment(audioProcessor.apvts, "Analyzer Enabled", analyz
     
     addAndMakeVisible(chatBox);
     
+    // the chat lives on in the processor, so it's still there when the editor reopens or the session reloads
+    chatBox.setTranscript(audioProcessor.getChatTranscript());
+    chatBox.onTranscriptChanged = [this]()
+    {
+        audioProcessor.setChatTranscript(chatBox.getTranscript());
+    };
+    
+    chatClient.resetConversation(ChatGPTClient::getDefaultSystemPrompt() + "\n\n" + promptEncoding.getSchema());
+    chatClient.setResponseSchema(promptEncoding.getResponseSchema());
+    
     chatBox.onUserMessage = [this](const juce::String& userInput)
     {
+        // a reply still streaming in is superseded by this message and stops here
+        finishReply(false);
+
         chatBox.appendMessage("You", userInput);
+        lastPrompt = userInput;
+        lastPromptFingerprint = promptEncoding.getStateFingerprint();
+        replyPreset = {};
+
+        const auto numCandidates = juce::jmax(1, candidateCountSelector.getSelectedId());
+
+        // asked before from these same settings: answer straight away, unless it's being asked
+        // again right after, which means the cached answer wasn't wanted. Options are always fresh.
+        auto match = numCandidates == 1 && userInput != lastCachedPrompt ? promptCache->find(userInput, lastPromptFingerprint) : std::nullopt;
+        lastCachedPrompt = {};
+
+        if (match.has_value())
+        {
+            auto preset = match->preset;
+            preset.morph = true;
+            audioProcessor.applyPreset(preset, userInput);
+
+            juce::String reply = ! match->exact
+                ? "Same settings as when you asked for \"" + match->prompt + "\". Ask again for a fresh answer."
+                : "Same settings as last time you asked for this. Ask again for a fresh answer.";
+
+            chatClient.cancelRequests();
+            chatBox.setStatus({});
+
+            chatBox.appendMessage("Genie", reply);
+            chatClient.addLocalExchange(userInput, reply);
+            lastCachedPrompt = userInput;
+            return;
+        }
+
+        // a built in preset that fits gets things close straight away. The model is asked to refine
+        // it, and the cache keeps the two together as the answer to this prompt
+        if (auto guess = genrePresets.find(userInput))
+        {
+            auto preset = guess->preset;
+            preset.morph = true;
+            audioProcessor.applyPreset(preset, guess->name + " preset");
 
-        // Inject JSON state
-        juce::String jsonState = getJSONFromParameters();
-        juce::String modifiedInput = userInput + R"(
+            chatBox.appendMessage("Genie", "Starting from the " + guess->name + " preset while I work out the details...");
+            replyPreset = guess->preset;
+        }
+
+        // the current values go as an attachment that only goes out with this message: the next one
+        // carries a newer state, so older ones are never sent again
+        auto attachment = "Current settings: " + promptEncoding.encodeState(replyPreset);
+
+        // whatever didn't fit in the last answer, so the model knows what actually happened to it
+        if (! problemsToReport.isEmpty())
+        {
+            attachment = "Fixed in your last reply: " + problemsToReport.joinIntoString("; ") + "\n" + attachment;
+            problemsToReport.clear();
+        }
+
+        if (numCandidates > 1)
+            attachment << "\n" << PromptParameterEncoding::getCandidatesRequest(numCandidates);
 
-        You are an expert audio engineer assistant. Your job is to listen to a user's prompt and output the appropriate EQ, compressor, distortion, delay, and reverb settings that would match the described genre, artist, or style. You will also be provided with the current state of the settings in JSON format.
+        replyCandidates = numCandidates;
+        chatClient.setResponseSchema(promptEncoding.getResponseSchema(numCandidates));
 
-        Please return:
-        1. A new JSON object (wrapped in triple backticks and marked as ```json ```) that contains the updated settings in the exact same format as they were provided.
-        2. Then, after closing the code block, write a plain text explanation (no markdown, no formatting) on a new line. Do not include any backticks or formatting after the JSON block. Do not reopen or continue the code block after the explanation.
+        chatClient.sendMessageAsync(userInput, attachment);
+    };
 
-        Here is the current plugin state in JSON format, follow its structure exactly:
-        )" + jsonState + R"(
 
-        Now, respond with the updated parameters and explanation.
-        )";
+    // replies stream in: the explanation goes straight into the chat and each parameter is applied
+    // as soon as its object is complete, all of them together making up one undo step
+    chatClient.onResponseText = [this](const juce::String& text)
+    {
+        if (! replyInProgress)
+        {
+            chatBox.beginMessage("Genie");
+            replyInProgress = true;
+        }
 
-        chatClient.sendMessageAsync(modifiedInput);
+        chatBox.appendToMessage(text);
     };
 
+    chatClient.onParameter = [this](const ReplyParameter& parameter)
+    {
+        applyStreamedParameter(parameter);
+    };
 
     chatClient.onResponse = [this](const juce::String& reply)
     {
-        std::cout << reply;
-        juce::MessageManager::callAsync([this, reply]()
+        // the options are read before the reply is closed, so anything that didn't fit is noted with it
+        if (replyCandidates > 1)
         {
-            // Utility to extract JSON block from triple-backtick markdown
-            auto extractJSONFromResponse = [](const juce::String& response) -> juce::String
-            {
-                int start = response.indexOf(juce::String("```json"));
-                if (start == -1)
-                    return {};
+            auto newCandidates = readCandidates(reply);
+            finishReply(true);
+            offerCandidates(std::move(newCandidates));
+            return;
+        }
 
-                start += juce::String("```json").length();
-                juce::String remaining = response.substring(start);
-                int relativeEnd = remaining.indexOf(juce::String("```"));
-                if (relativeEnd == -1)
-                    return {};
+        finishReply(true);
+    };
 
-                int end = start + relativeEnd;
-                return response.substring(start, end).trim();
-            };
+    chatClient.onRequestStatus = [this](ChatGPTClient::RequestStatus status, const juce::String& detail)
+    {
+        using RequestStatus = ChatGPTClient::RequestStatus;
 
-            auto extractExplanation = [](const juce::String& response) -> juce::String
+        switch (status)
+        {
+            case RequestStatus::queued:    chatBox.setStatus(detail.isNotEmpty() ? detail : "Waiting to send..."); break;
+            case RequestStatus::sending:   chatBox.setStatus("Asking " + chatClient.getBackendName() + "..."); break;
+            case RequestStatus::receiving: chatBox.setStatus("Genie is answering..."); break;
+            case RequestStatus::finished:
             {
-                int codeStart = response.indexOf(juce::String("```json"));
-                int codeEnd = -1;
-                if (codeStart != -1)
-                {
-                    juce::String remaining = response.substring(codeStart + juce::String("```json").length());
-                    int relativeEnd = remaining.indexOf(juce::String("```"));
-                    if (relativeEnd != -1)
-                    {
-                        codeEnd = codeStart + juce::String("```json").length() + relativeEnd + juce::String("```").length();
-                    }
-                }
-
-                // Return everything except the JSON block
-                if (codeStart != -1 && codeEnd != -1)
-                    return (response.substring(0, codeStart) + "\n" + response.substring(codeEnd)).trim();
-
-                return response.trim(); // fallback: return whole thing
-            };
-
-            const juce::String jsonBlock = extractJSONFromResponse(reply);
-            const juce::String explanation = extractExplanation(reply);
-
-            if (!explanation.isEmpty())
-                chatBox.appendMessage("Genie", explanation);
-
-            if (!jsonBlock.isEmpty()) {
-                //chatBox.appendMessage("Bot (JSON)", jsonBlock);
-                applyParametersFromJSON(jsonBlock);  // <- Apply to plugin
+                auto metrics = chatClient.getLastRequestMetrics();
+                chatBox.setStatus("Answered in " + juce::String(metrics.totalMs / 1000.0, 1) + " s, first words after "
+                                  + juce::String(metrics.firstByteMs / 1000.0, 1) + " s");
+                break;
             }
-        });
+            case RequestStatus::failed:
+                finishReply(false);
+                chatBox.setStatus("No answer from " + chatClient.getBackendName() + (detail.isNotEmpty() ? " (" + detail + ")" : juce::String()));
+                break;
+        }
     };
-
 }
 
 SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
@@ -934,105 +1014,260 @@ SimpleEQAudioProcessorEditor::~SimpleEQAudioProcessorEditor()
     analyzerEnabledButton.setLookAndFeel(nullptr);
 }
 
-juce::String SimpleEQAudioProcessorEditor::getJSONFromParameters() const
+void SimpleEQAudioProcessorEditor::applyStreamedParameter(const ReplyParameter& parameter)
 {
-    juce::DynamicObject::Ptr root = new juce::DynamicObject();
-    juce::Array<juce::var> eqParams;
+    ParameterPreset preset;
+    preset.morph = true;
 
-    auto addParam = [&](const juce::String& id, const juce::String& type, const juce::String& unit,
-                        std::optional<std::pair<float, float>> range,
-                        std::optional<std::vector<int>> choices,
-                        float currentVal)
-    {
-        auto* obj = new juce::DynamicObject();
-        obj->setProperty("id", id);
-        obj->setProperty("type", type);
-        obj->setProperty("unit", unit);
-        obj->setProperty("current", currentVal);
+    if (! addParameterToPreset(parameter, preset))
+        return;
+
+    if (numStreamedParameters++ == 0)
+        audioProcessor.beginHistoryStep(lastPrompt);
+
+    replyPreset.mergeFrom(preset);
+
+    // a reply that arrives in one piece goes out as one preset rather than one per value
+    streamedPreset.mergeFrom(preset);
+    hasStreamedValues = true;
+    scheduleStreamedFlush(0);
+}
+
+void SimpleEQAudioProcessorEditor::scheduleStreamedFlush(int delayMs)
+{
+    if (streamedFlushScheduled)
+        return;
 
-        if (range.has_value())
+    streamedFlushScheduled = true;
+
+    auto flush = [safePtr = juce::Component::SafePointer<SimpleEQAudioProcessorEditor>(this)]()
+    {
+        if (auto* editor = safePtr.getComponent())
         {
-            juce::Array<juce::var> rangeArray;
-            rangeArray.add(range->first);
-            rangeArray.add(range->second);
-            obj->setProperty("range", juce::var(rangeArray));
+            editor->streamedFlushScheduled = false;
+            editor->flushStreamedParameters();
         }
+    };
+
+    if (delayMs > 0)
+        juce::Timer::callAfterDelay(delayMs, flush);
+    else
+        juce::MessageManager::callAsync(flush);
+}
+
+void SimpleEQAudioProcessorEditor::flushStreamedParameters()
+{
+    if (! hasStreamedValues)
+        return;
+
+    // with the queue full the values wait, later ones joining them, until the processor has caught up
+    if (! audioProcessor.applyPreset(streamedPreset, lastPrompt))
+    {
+        scheduleStreamedFlush(streamedRetryMs);
+        return;
+    }
+
+    streamedPreset = {};
+    hasStreamedValues = false;
+}
+
+void SimpleEQAudioProcessorEditor::finishReply(bool completed)
+{
+    if (replyInProgress)
+    {
+        if (! completed)
+            chatBox.appendToMessage(" (interrupted)");
+
+        chatBox.endMessage();
+    }
+
+    // whatever is still waiting belongs in the reply's undo step
+    flushStreamedParameters();
+    audioProcessor.endHistoryStep();
+
+    if (completed && numStreamedParameters > 0)
+        promptCache->store(lastPrompt, lastPromptFingerprint, replyPreset);
+
+    if (! replyProblems.isEmpty())
+    {
+        chatBox.appendMessage("Note", replyProblems.joinIntoString("; "));
+        problemsToReport.addArray(replyProblems);
+        replyProblems.clear();
+    }
+
+    replyInProgress = false;
+    numStreamedParameters = 0;
+}
+
+bool SimpleEQAudioProcessorEditor::addParameterToPreset(const ReplyParameter& parameter, ParameterPreset& preset)
+{
+    // out of range values are clamped rather than dropped, but the model still hears about them
+    auto decoded = promptEncoding.decode(parameter);
+    if (decoded.problem.isNotEmpty())
+        replyProblems.add(decoded.problem);
+
+    if (! decoded.isValid())
+        return false;
+
+    preset.set(decoded.parameterIndex, decoded.value);
+    return true;
+}
+
+std::vector<SimpleEQAudioProcessorEditor::Candidate> SimpleEQAudioProcessorEditor::readCandidates(const juce::String& reply)
+{
+    // all of the reply with structured output, otherwise the fenced block in it
+    auto json = reply.trim();
+    if (! json.startsWithChar('{'))
+    {
+        auto start = reply.indexOf("```");
+        auto end = start >= 0 ? reply.indexOf(start + 3, "```") : -1;
+        if (end < 0)
+            return {};
+
+        json = reply.substring(start + 3, end);
+        if (! json.trimStart().startsWithChar('{'))
+            json = json.fromFirstOccurrenceOf("\n", false, false);
+    }
+
+    std::vector<Candidate> result;
 
-        if (choices.has_value())
+    auto parsed = juce::JSON::parse(json);
+
+    if (auto* list = parsed["candidates"].getArray())
+    {
+        for (const auto& entry : *list)
         {
-            juce::Array<juce::var> choiceArray;
-            for (auto c : *choices)
-                choiceArray.add(c);
-            obj->setProperty("choices", juce::var(choiceArray));
-        }
+            if ((int)result.size() == CandidateAudition::maxCandidates)
+                break;
 
-        eqParams.add(juce::var(obj));
-    };
+            Candidate candidate;
+            candidate.name = entry["name"].toString().trim();
+            if (candidate.name.isEmpty())
+                candidate.name = "Option " + juce::String((int)result.size() + 1);
 
-    // Populate with your parameters
-    addParam("LowCut Freq", "Low Cut", "Hz", {{20, 20000}}, std::nullopt, lowCutFreqSlider.getValue());
-    addParam("LowCut Slope", "Low Cut Slope", "dB/Oct", std::nullopt, {{12, 24, 36, 48}}, lowCutSlopeSlider.getValue());
-    addParam("Peak Freq", "Peak Band", "Hz", {{20, 20000}}, std::nullopt, peakFreqSlider.getValue());
-    addParam("Peak Gain", "Peak Gain", "dB", {{-24, 24}}, std::nullopt, peakGainSlider.getValue());
-    addParam("Peak Quality", "Q (Bandwidth)", "Q", {{0.1f, 10.f}}, std::nullopt, peakQualitySlider.getValue());
-    addParam("HighCut Freq", "High Cut", "Hz", {{20, 20000}}, std::nullopt, highCutFreqSlider.getValue());
-    addParam("HighCut Slope", "High Cut Slope", "dB/Oct", std::nullopt, {{12, 24, 36, 48}}, highCutSlopeSlider.getValue());
-    
-    addParam("Comp Threshold", "Compressor", "dB", {{-60.f, 0.f}}, std::nullopt, compThresholdSlider.getValue());
-    addParam("Comp Ratio", "Compressor", ":1", {{1.f, 20.f}}, std::nullopt, compRatioSlider.getValue());
-    addParam("Comp Attack", "Compressor", "ms", {{1.f, 100.f}}, std::nullopt, compAttackSlider.getValue());
-    addParam("Comp Release", "Compressor", "ms", {{10.f, 500.f}}, std::nullopt, compReleaseSlider.getValue());
-    
-    // Distortion
-    addParam("Distortion Amount", "Distortion", "", {{0.f, 1.f}}, std::nullopt, distortionAmountSlider.getValue());
+            candidate.description = lastPrompt + " (" + candidate.name + ")";
 
-    // Delay
-    addParam("Delay Time", "Delay", "ms", {{1.f, 2000.f}}, std::nullopt, delayTimeSlider.getValue());
-    addParam("Delay Feedback", "Delay", "", {{0.f, 0.95f}}, std::nullopt, delayFeedbackSlider.getValue());
-    addParam("Delay Mix", "Delay", "%", {{0.f, 100.f}}, std::nullopt, delayMixSlider.getValue());
+            if (auto* values = entry["set"].getArray())
+                for (const auto& value : *values)
+                    addParameterToPreset(ReplyParameter::fromVar(value), candidate.preset);
 
-    // Reverb
-    addParam("Reverb Size", "Reverb", "", {{0.f, 1.f}}, std::nullopt, reverbSizeSlider.getValue());
-    addParam("Reverb Decay", "Reverb", "s", {{0.f, 10.f}}, std::nullopt, reverbDecaySlider.getValue());
-    addParam("Reverb Mix", "Reverb", "%", {{0.f, 100.f}}, std::nullopt, reverbMixSlider.getValue());
+            result.push_back(std::move(candidate));
+        }
+    }
 
-    root->setProperty("eq_parameters", juce::var(eqParams));
-    
-    DBG(juce::JSON::toString(juce::var(root.get()), true));
-    return juce::JSON::toString(juce::var(root.get()), true);
+    return result;
 }
 
-void SimpleEQAudioProcessorEditor::applyParametersFromJSON(const juce::String& jsonString)
+void SimpleEQAudioProcessorEditor::offerCandidates(std::vector<Candidate> newCandidates)
 {
-    juce::var parsed = juce::JSON::parse(jsonString);
-    if (!parsed.isObject())
+    if (newCandidates.empty())
+    {
+        chatBox.appendMessage("Note", "The reply didn't have any options to compare.");
         return;
+    }
 
-    auto* obj = parsed.getDynamicObject();
-    if (!obj)
+    candidates = std::move(newCandidates);
+
+    juce::StringArray names;
+    for (size_t index = 0; index < candidates.size(); ++index)
+        names.add(juce::String((int)index + 1) + ". " + candidates[index].name);
+
+    // the last few seconds of input, rendered through every option at once on their own chains
+    juce::AudioBuffer<float> loop;
+    double sampleRate = 0;
+
+    if (audioProcessor.previewCapture.getLoop(loop, sampleRate))
+    {
+        std::vector<ChainSettings> settings;
+        for (auto& candidate : candidates)
+        {
+            settings.push_back(audioProcessor.getChainSettings(candidate.preset));
+            candidate.previewPending = true;
+        }
+
+        previewRenderer.render(loop, sampleRate, settings);
+        chatBox.appendMessage("Genie", "Options: " + names.joinIntoString(", ")
+                              + ". Click one to hear it on your last few seconds of audio, then Keep it or go back to Live.");
+    }
+    else
+    {
+        previewRenderer.cancel();
+        chatBox.appendMessage("Genie", "Options: " + names.joinIntoString(", ")
+                              + ". Play some audio to preview them on it, until then clicking one applies it.");
+    }
+
+    updateCandidateButtons();
+}
+
+void SimpleEQAudioProcessorEditor::auditionCandidate(int candidate)
+{
+    if (! juce::isPositiveAndBelow(candidate, (int)candidates.size()))
+    {
+        audioProcessor.candidateAudition.select(-1);
+        chatBox.setStatus({});
+        updateCandidateButtons();
         return;
+    }
+
+    const auto& chosen = candidates[(size_t)candidate];
 
-    juce::var eqParams = obj->getProperty("eq_parameters");
-    if (!eqParams.isArray())
+    if (chosen.previewPending && ! chosen.previewReady)
+    {
+        chatBox.setStatus("Still rendering " + chosen.name + "...");
         return;
+    }
 
-    for (const juce::var& paramVar : *eqParams.getArray())
+    // nothing to preview on, so the only way to hear it is to use it
+    if (! chosen.previewReady)
     {
-        auto* paramObj = paramVar.getDynamicObject();
-        if (!paramObj)
-            continue;
+        audioProcessor.candidateAudition.select(-1);
 
-        juce::String id    = paramObj->getProperty("id").toString();
-        juce::String type  = paramObj->getProperty("type").toString();  // optional
-        float currentValue = static_cast<float>(paramObj->getProperty("current"));
+        auto preset = chosen.preset;
+        preset.morph = true;
+        audioProcessor.applyPreset(preset, chosen.description);
+        chatBox.setStatus("Applied " + chosen.name);
+        updateCandidateButtons();
+        return;
+    }
 
-        if (auto* p = audioProcessor.apvts.getParameter(id))
-        {
-            p->beginChangeGesture();
-            p->setValueNotifyingHost(p->convertTo0to1(currentValue));
-            p->endChangeGesture();
-        }
+    audioProcessor.candidateAudition.select(candidate);
+    chatBox.setStatus("Previewing " + chosen.name + ", Keep to use it");
+    updateCandidateButtons();
+}
+
+void SimpleEQAudioProcessorEditor::keepCandidate()
+{
+    const auto candidate = audioProcessor.candidateAudition.getSelected();
+    if (! juce::isPositiveAndBelow(candidate, (int)candidates.size()))
+        return;
+
+    // no glide: the live chain should sound like the preview did the moment the output switches back to it
+    const auto& chosen = candidates[(size_t)candidate];
+    audioProcessor.applyPreset(chosen.preset, chosen.description);
+    audioProcessor.candidateAudition.select(-1);
+
+    chatBox.appendMessage("Genie", "Kept " + chosen.name + ".");
+    chatBox.setStatus({});
+    updateCandidateButtons();
+}
+
+void SimpleEQAudioProcessorEditor::updateCandidateButtons()
+{
+    const auto selected = audioProcessor.candidateAudition.getSelected();
+
+    for (int candidate = 0; candidate < CandidateAudition::maxCandidates; ++candidate)
+    {
+        auto& button = candidateButtons[(size_t)candidate];
+        const auto exists = candidate < (int)candidates.size();
+
+        button.setEnabled(exists);
+        button.setToggleState(exists && candidate == selected, juce::dontSendNotification);
+        button.setTooltip(exists ? candidates[(size_t)candidate].name : juce::String());
+        button.setAlpha(exists && ! candidates[(size_t)candidate].previewReady ? 0.5f : 1.f);
     }
+
+    liveButton.setEnabled(selected >= 0);
+    keepCandidateButton.setEnabled(selected >= 0);
 }
 
 
@@ -1152,10 +1387,31 @@ void SimpleEQAudioProcessorEditor::resized()
     auto responseArea = leftColumn.removeFromTop(responseHeight);
     responseCurveComponent.setBounds(responseArea);
 
+    auto tapArea = leftColumn.removeFromTop(24);
+    auto tapWidth = tapArea.getWidth() / 3;
+    leftAnalyzerTapSelector.setBounds(tapArea.removeFromLeft(tapWidth).reduced(4, 2));
+    rightAnalyzerTapSelector.setBounds(tapArea.removeFromLeft(tapWidth).reduced(4, 2));
+    backendSelector.setBounds(tapArea.reduced(4, 2));
+
+    auto candidateArea = leftColumn.removeFromTop(28);
+    candidateCountSelector.setBounds(candidateArea.removeFromLeft(candidateArea.getWidth() / 3).reduced(4, 2));
+    auto candidateButtonWidth = candidateArea.getWidth() / (CandidateAudition::maxCandidates + 4);
+    for( auto& button : candidateButtons )
+        button.setBounds(candidateArea.removeFromLeft(candidateButtonWidth).reduced(2));
+    keepCandidateButton.setBounds(candidateArea.removeFromRight(candidateButtonWidth * 2).reduced(2));
+    liveButton.setBounds(candidateArea.removeFromRight(candidateButtonWidth * 2).reduced(2));
+
     chatBox.setBounds(leftColumn);
 
     // === MIDDLE COLUMN ===
-    middleColumn.removeFromTop(40);
+    auto slotArea = middleColumn.removeFromTop(40).reduced(4, 8);
+    auto slotWidth = slotArea.getWidth() / (SimpleEQAudioProcessor::numSnapshotSlots + 8);
+    for( auto& button : snapshotSlotButtons )
+        button.setBounds(slotArea.removeFromLeft(slotWidth).reduced(2, 0));
+    storeSnapshotButton.setBounds(slotArea.removeFromLeft(slotWidth * 2).reduced(2, 0));
+    moreButton.setBounds(slotArea.removeFromRight(slotWidth * 2).reduced(2, 0));
+    redoButton.setBounds(slotArea.removeFromRight(slotWidth * 2).reduced(2, 0));
+    undoButton.setBounds(slotArea.removeFromRight(slotWidth * 2).reduced(2, 0));
     auto eqArea = middleColumn.removeFromTop(middleColumn.getHeight() * 0.6f);
     auto eqColumnWidth = eqArea.getWidth() / 3;
 
@@ -1245,6 +1501,133 @@ void SimpleEQAudioProcessorEditor::resized()
 
 
 
+//==============================================================================
+AdvancedControlsComponent::AdvancedControlsComponent(juce::AudioProcessorValueTreeState& apvts)
+{
+    for( auto* parameterID : { "Linear Phase", "Linear Phase Length", "Chain Order", "Morph Time", "Morph Position",
+                               "Comp Sidechain", "Comp Sidechain HighPass",
+                               "Comp Multiband", "Comp Bands", "Comp Crossover Low", "Comp Crossover Mid", "Comp Crossover High" } )
+    {
+        addControl(apvts, parameterID, mainControls);
+    }
+    
+    for( int band = 1; band <= 4; ++band )
+        for( auto* name : { "Threshold", "Ratio", "Attack", "Release" } )
+            addControl(apvts, "Comp Band" + juce::String(band) + " " + name, bandControls);
+    
+    const auto numRows = (int)juce::jmax(mainControls.size(), bandControls.size());
+    setSize(680, numRows * rowHeight + 16);
+}
+
+void AdvancedControlsComponent::addControl(APVTS& apvts, const juce::String& parameterID, std::vector<std::unique_ptr<Control>>& column)
+{
+    auto* parameter = apvts.getParameter(parameterID);
+    jassert(parameter != nullptr);
+    if( parameter == nullptr )
+        return;
+    
+    auto control = std::make_unique<Control>();
+    control->label.setText(parameter->getName(32), juce::dontSendNotification);
+    addAndMakeVisible(control->label);
+    
+    // the control follows the kind of parameter, like the host's generic editor would
+    if( dynamic_cast<juce::AudioParameterBool*>(parameter) != nullptr )
+    {
+        auto button = std::make_unique<juce::ToggleButton>();
+        control->buttonAttachment = std::make_unique<APVTS::ButtonAttachment>(apvts, parameterID, *button);
+        control->component = std::move(button);
+    }
+    else if( auto* choice = dynamic_cast<juce::AudioParameterChoice*>(parameter) )
+    {
+        // the items have to be there before the attachment picks one
+        auto comboBox = std::make_unique<juce::ComboBox>();
+        comboBox->addItemList(choice->choices, 1);
+        control->comboBoxAttachment = std::make_unique<APVTS::ComboBoxAttachment>(apvts, parameterID, *comboBox);
+        control->component = std::move(comboBox);
+    }
+    else
+    {
+        auto slider = std::make_unique<juce::Slider>(juce::Slider::LinearHorizontal, juce::Slider::TextBoxRight);
+        slider->setTextBoxStyle(juce::Slider::TextBoxRight, false, 64, rowHeight - 4);
+        control->sliderAttachment = std::make_unique<APVTS::SliderAttachment>(apvts, parameterID, *slider);
+        control->component = std::move(slider);
+    }
+    
+    addAndMakeVisible(*control->component);
+    column.push_back(std::move(control));
+}
+
+void AdvancedControlsComponent::resized()
+{
+    auto bounds = getLocalBounds().reduced(8);
+    auto left = bounds.removeFromLeft(bounds.getWidth() / 2).withTrimmedRight(8);
+    
+    layOut(mainControls, left);
+    layOut(bandControls, bounds);
+}
+
+void AdvancedControlsComponent::layOut(std::vector<std::unique_ptr<Control>>& column, juce::Rectangle<int> area)
+{
+    for( auto& control : column )
+    {
+        auto row = area.removeFromTop(rowHeight);
+        control->label.setBounds(row.removeFromLeft(row.getWidth() * 2 / 5));
+        control->component->setBounds(row.reduced(0, 1));
+    }
+}
+
+void SimpleEQAudioProcessorEditor::updateSnapshotSlotButtons()
+{
+    const auto activeSlot = audioProcessor.getActiveSnapshotSlot();
+    
+    for( int slot = 0; slot < SimpleEQAudioProcessor::numSnapshotSlots; ++slot )
+    {
+        auto& button = snapshotSlotButtons[(size_t)slot];
+        const auto stored = audioProcessor.isSnapshotSlotStored(slot);
+        
+        button.setToggleState(stored && slot == activeSlot, juce::dontSendNotification);
+        button.setAlpha(stored ? 1.f : 0.5f);
+    }
+}
+
+void SimpleEQAudioProcessorEditor::timerCallback()
+{
+    if( audioProcessor.getChannelLayoutOfBus(false, 0) != analyzerTapLayout )
+        updateAnalyzerTapSelectors();
+}
+
+void SimpleEQAudioProcessorEditor::updateAnalyzerTapSelectors()
+{
+    analyzerTapLayout = audioProcessor.getChannelLayoutOfBus(false, 0);
+    
+    populateAnalyzerTapSelector(leftAnalyzerTapSelector, audioProcessor.leftChannelFifo);
+    populateAnalyzerTapSelector(rightAnalyzerTapSelector, audioProcessor.rightChannelFifo);
+}
+
+void SimpleEQAudioProcessorEditor::populateAnalyzerTapSelector(juce::ComboBox& selector,
+                                                               SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>& fifo)
+{
+    const auto& layout = analyzerTapLayout;
+    selector.clear(juce::dontSendNotification);
+    
+    for( int channel = 0; channel < layout.size(); ++channel )
+    {
+        auto name = juce::AudioChannelSet::getChannelTypeName(layout.getTypeOfChannel(channel));
+        selector.addItem(name, channel + 1);
+    }
+    
+    // a trace following a channel the new layout doesn't have moves to its last one
+    const auto channel = juce::jlimit(0, juce::jmax(0, layout.size() - 1), fifo.getChannelToUse());
+    fifo.setChannelToUse(channel);
+    selector.setSelectedId(channel + 1, juce::dontSendNotification);
+    
+    selector.onChange = [&selector, &fifo]()
+    {
+        if( selector.getSelectedId() > 0 )
+            fifo.setChannelToUse(selector.getSelectedId() - 1);
+    };
+}
+
 std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComps()
 {
     return
@@ -1257,6 +1640,8 @@ std::vector<juce::Component*> SimpleEQAudioProcessorEditor::getComps()
         &lowCutSlopeSlider,
         &highCutSlopeSlider,
         &responseCurveComponent,
+        &leftAnalyzerTapSelector,
+        &rightAnalyzerTapSelector,
         
         &lowcutBypassButton,
         &peakBypassButton,
@@ -12,6 +12,9 @@
 #include "PluginProcessor.h"
 #include "ChatBoxComponent.h"
 #include "ChatGPTClient.h"
+#include "PromptEncoding.h"
+#include "PromptCache.h"
+#include "GenrePresets.h"
 
 enum FFTOrder
 {
@@ -240,15 +243,9 @@ private:
 };
 
 struct ResponseCurveComponent: juce::Component,
-juce::AudioProcessorParameter::Listener,
 juce::Timer
 {
     ResponseCurveComponent(SimpleEQAudioProcessor&);
-    ~ResponseCurveComponent();
-    
-    void parameterValueChanged (int parameterIndex, float newValue) override;
-
-    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override { }
     
     void timerCallback() override;
     
@@ -264,9 +261,7 @@ private:
 
     bool shouldShowFFTAnalysis = true;
 
-    juce::Atomic<bool> parametersChanged { false };
-    
-    MonoChain monoChain;
+    ChainSnapshot snapshot;
 
     void updateResponseCurve();
     
@@ -313,9 +308,42 @@ struct AnalyzerButton : juce::ToggleButton
     
     juce::Path randomPath;
 };
+
+/**
+ Plain controls for the parameters without a place on the main panel: linear phase, the
+ sidechain and multiband compressor with its bands, the stage order and morphing. Shown in a
+ call-out from the editor's "More" button.
+ */
+struct AdvancedControlsComponent : juce::Component
+{
+    explicit AdvancedControlsComponent(juce::AudioProcessorValueTreeState& apvts);
+    
+    void resized() override;
+private:
+    using APVTS = juce::AudioProcessorValueTreeState;
+    
+    struct Control
+    {
+        juce::Label label;
+        std::unique_ptr<juce::Component> component;
+        
+        // after the component, so they're gone before it is
+        std::unique_ptr<APVTS::SliderAttachment> sliderAttachment;
+        std::unique_ptr<APVTS::ButtonAttachment> buttonAttachment;
+        std::unique_ptr<APVTS::ComboBoxAttachment> comboBoxAttachment;
+    };
+    
+    std::vector<std::unique_ptr<Control>> mainControls, bandControls;
+    
+    static constexpr int rowHeight = 22;
+    
+    void addControl(APVTS& apvts, const juce::String& parameterID, std::vector<std::unique_ptr<Control>>& column);
+    static void layOut(std::vector<std::unique_ptr<Control>>& column, juce::Rectangle<int> area);
+};
+
 /**
 */
-class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor
+class SimpleEQAudioProcessorEditor  : public juce::AudioProcessorEditor, private juce::Timer
 {
 public:
     SimpleEQAudioProcessorEditor (SimpleEQAudioProcessor&);
@@ -324,9 +352,6 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
-    
-    juce::String getJSONFromParameters() const;
-    void applyParametersFromJSON(const juce::String& jsonString);
 
 private:
     // This reference is provided as a quick way for your editor to
@@ -359,8 +384,91 @@ private:
     
     ResponseCurveComponent responseCurveComponent;
     
+    // pick which bus channels the two analyzer traces follow, rebuilt when the layout changes
+    juce::ComboBox leftAnalyzerTapSelector, rightAnalyzerTapSelector;
+    juce::AudioChannelSet analyzerTapLayout;
+    void timerCallback() override;
+    void updateAnalyzerTapSelectors();
+    void populateAnalyzerTapSelector(juce::ComboBox& selector, SingleChannelSampleFifo<SimpleEQAudioProcessor::BlockType>& fifo);
+    
+    // A/B/C/D: clicking an empty slot stores the current settings in it, a stored one recalls it
+    std::array<juce::TextButton, SimpleEQAudioProcessor::numSnapshotSlots> snapshotSlotButtons;
+    juce::TextButton storeSnapshotButton { "Store" };
+    void updateSnapshotSlotButtons();
+    
+    juce::TextButton undoButton { "Undo" }, redoButton { "Redo" };
+    
+    // everything the knobs don't cover, in a call-out
+    juce::TextButton moreButton { "More" };
+    
+    // the prompt the next AI answer belongs to, which labels its undo step
+    juce::String lastPrompt;
+    
+    // the reply currently streaming in
+    bool replyInProgress = false;
+    int numStreamedParameters = 0;
+    
+    void applyStreamedParameter(const ReplyParameter& parameter);
+    
+    // streamed values not yet handed to the processor, which go out together once per message loop turn
+    ParameterPreset streamedPreset;
+    bool hasStreamedValues = false, streamedFlushScheduled = false;
+    static constexpr int streamedRetryMs = 50;
+    
+    void scheduleStreamedFlush(int delayMs);
+    void flushStreamedParameters();
+    
+    // closes the reply's message and undo step, whether it finished or was cut short
+    void finishReply(bool completed);
+    bool addParameterToPreset(const ReplyParameter& parameter, ParameterPreset& preset);
+    
+    // values from the reply that were rejected or clamped: shown once it's finished, and
+    // told to the model with the next message
+    juce::StringArray replyProblems, problemsToReport;
+    
     ChatGPTClient chatClient;
     
+    // the schema goes out once in the system prompt, each message only carries the values
+    PromptParameterEncoding promptEncoding { audioProcessor.apvts };
+    
+    // earlier answers, which a repeated request is served from without a round trip
+    juce::SharedResourcePointer<PromptPresetCache> promptCache;
+    juce::uint64 lastPromptFingerprint = 0;
+    juce::String lastCachedPrompt;
+    ParameterPreset replyPreset;
+    
+    // a first guess that's there instantly, and without the network, while the model refines it
+    GenrePresetLibrary genrePresets { promptEncoding };
+    
+    // which LLM service the chat talks to, switchable between requests
+    juce::ComboBox backendSelector;
+    
+    // several takes on one prompt in a single reply, each rendered on a loop of the input so
+    // they can be compared by ear before one is kept
+    struct Candidate
+    {
+        juce::String name, description;
+        ParameterPreset preset;
+        bool previewPending = false, previewReady = false;
+    };
+    
+    juce::ComboBox candidateCountSelector;
+    std::array<juce::TextButton, CandidateAudition::maxCandidates> candidateButtons;
+    juce::TextButton liveButton { "Live" }, keepCandidateButton { "Keep" };
+    
+    std::vector<Candidate> candidates;
+    
+    // how many takes the reply in flight was asked for
+    int replyCandidates = 1;
+    
+    CandidatePreviewRenderer previewRenderer { audioProcessor.candidateAudition };
+    
+    std::vector<Candidate> readCandidates(const juce::String& reply);
+    void offerCandidates(std::vector<Candidate> newCandidates);
+    void auditionCandidate(int candidate);
+    void keepCandidate();
+    void updateCandidateButtons();
+    
     using APVTS = juce::AudioProcessorValueTreeState;
     using Attachment = APVTS::SliderAttachment;
     
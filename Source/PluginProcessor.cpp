@@ -16,16 +16,49 @@ SimpleEQAudioProcessor::SimpleEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    for( auto* param : getParameters() )
+    {
+        param->addListener(this);
+        
+        if( auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param) )
+        {
+            auto idHash = (juce::uint32)paramWithID->paramID.hashCode();
+            jassert(! parameterIndicesByHash.contains(idHash));
+            
+            parameterIndices.set(paramWithID->paramID, param->getParameterIndex());
+            parameterIndicesByHash.set(idHash, param->getParameterIndex());
+            parameterLayoutHash = parameterLayoutHash * 31 + idHash;
+        }
+    }
+    
+    jassert(getParameters().size() <= ParameterPreset::maxParameters);
+    
+    // so the audio thread never has to build an ID or search for one when it rebuilds the settings
+    for( int chainParameter = 0; chainParameter < numChainParameters; ++chainParameter )
+    {
+        auto parameterID = getChainParameterID(chainParameter);
+        
+        chainParameterValues[(size_t)chainParameter] = apvts.getRawParameterValue(parameterID);
+        chainParameterIndices[(size_t)chainParameter] = parameterIndices.contains(parameterID) ? parameterIndices[parameterID] : -1;
+        jassert(chainParameterValues[(size_t)chainParameter] != nullptr);
+    }
+    
+    startTimerHz(30);
 }
 
 SimpleEQAudioProcessor::~SimpleEQAudioProcessor()
 {
+    stopTimer();
+    
+    for( auto* param : getParameters() )
+        param->removeListener(this);
 }
 
 //==============================================================================
@@ -63,7 +96,7 @@ bool SimpleEQAudioProcessor::isMidiEffect() const
 
 double SimpleEQAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    return chainSnapshots.read().tailSeconds;
 }
 
 int SimpleEQAudioProcessor::getNumPrograms()
@@ -98,28 +131,31 @@ void SimpleEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlo
     
     juce::dsp::ProcessSpec spec;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
+    spec.numChannels = getTotalNumOutputChannels();
     spec.sampleRate = sampleRate;
     
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // the host picks the precision before preparing us, but preparing both keeps
+    // a late switch from ever running an unprepared chain
+    floatChain.prepare(spec);
+    doubleChain.prepare(spec);
     
-    // Compressor is stereo
-    spec.numChannels = getTotalNumOutputChannels();
-    compressor.prepare(spec);
+    // stored slots were designed for the old rate, and recalling one mustn't have to redesign it
+    updateSnapshotSlotsForSampleRate();
     
-    // Reverb is stereo
-    reverb.prepare(spec);
-
-    // Optional: set initial delay size
-    delayLine.setDelay(apvts.getRawParameterValue("Delay Time")->load());
-    delayLine.prepare(spec);
+    {
+        // the sample rate may have changed, so redesign even if no parameter moved
+        const juce::SpinLock::ScopedLockType lock(publishLock);
+        publishSettings();
+    }
     
-    updateSettings();
-    updateDelaySettings();
+    silentInputSamples = 0;
     
     leftChannelFifo.prepare(samplesPerBlock);
     rightChannelFifo.prepare(samplesPerBlock);
+    
+    // previews rendered at another sample rate would play at the wrong speed
+    previewCapture.prepare(sampleRate, getMainBusNumInputChannels());
+    candidateAudition.clear();
 }
 
 void SimpleEQAudioProcessor::releaseResources()
@@ -135,18 +171,20 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (//layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo()
-        layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Anything from mono up to maxChannels works, including the surround and
+    // immersive layouts, since every stage in the chain handles N channels.
+    const auto& mainOutput = layouts.getMainOutputChannelSet();
+    if (mainOutput.isDisabled() || mainOutput.size() > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // the optional sidechain only feeds the compressor's detector, mono or stereo
+    if (layouts.inputBuses.size() > 1 && layouts.getChannelSet(true, 1).size() > 2)
+        return false;
    #endif
 
     return true;
@@ -155,6 +193,17 @@ bool SimpleEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts)
 #endif
 
 void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processChain(buffer, floatChain);
+}
+
+void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    processChain(buffer, doubleChain);
+}
+
+template<typename SampleType>
+void SimpleEQAudioProcessor::processChain(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain)
 {
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -163,105 +212,76 @@ void SimpleEQAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear(i, 0, buffer.getNumSamples());
 
-    updateSettings();
+    lastBlockTime.store(juce::Time::getMillisecondCounter());
+    applyPendingPresets();
+    publishSettingsIfChanged();
 
-    juce::dsp::AudioBlock<float> block(buffer);
-
-    /**========================
-     *   1. Process EQ
-     *=========================*/
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-
-    leftChain.process(leftContext);
-    rightChain.process(rightContext);
-
-    /**========================
-     *   2. Compressor
-     *=========================*/
-    if (!apvts.getRawParameterValue("Comp Bypassed")->load())
+    const auto snapshot = chainSnapshots.read();
+    if( snapshot.generation != chain.getAppliedGeneration() )
+        chain.applySnapshot(snapshot);
+    
+    /*
+     once the input has been silent for longer than the chain rings, the output is
+     silent as well, so there is nothing to process and nothing new for the analyzer.
+     */
+    const auto silenceThreshold = juce::Decibels::decibelsToGain((SampleType)silenceThresholdInDecibels);
+    
+    // the sidechain channels follow the main ones in 'buffer'; both of these just point into it
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    auto sidechainBuffer = getBusCount(true) > 1 ? getBusBuffer(buffer, true, 1) : juce::AudioBuffer<SampleType>();
+    
+    if( mainBuffer.getMagnitude(0, mainBuffer.getNumSamples()) < silenceThreshold )
     {
-        juce::dsp::ProcessContextReplacing<float> context(block);
-        compressor.process(context);
+        silentInputSamples += mainBuffer.getNumSamples();
     }
-
-    /**========================
-     *   3. Distortion
-     *=========================*/
-    if (!apvts.getRawParameterValue("Distortion Bypassed")->load())
+    else
     {
-        float amount = apvts.getRawParameterValue("Distortion Amount")->load();
-        distortion.functionToUse = [amount](float x)
-        {
-            return std::tanh(amount * x);
-        };
-
-        auto numChannels = block.getNumChannels();
-        auto numSamples = block.getNumSamples();
-
-        for (size_t ch = 0; ch < numChannels; ++ch)
-        {
-            for (size_t i = 0; i < numSamples; ++i)
-            {
-                auto sample = block.getSample(ch, i);
-                block.setSample(ch, i, distortion.functionToUse(sample));
-            }
-        }
+        silentInputSamples = 0;
+        previewCapture.push(mainBuffer);
     }
-
-
-
-    /**========================
-     *   4. Delay
-     *=========================*/
-    if (!apvts.getRawParameterValue("Delay Bypassed")->load() && false)
+    
+    const auto tailSamples = juce::int64(snapshot.tailSeconds * getSampleRate()) + mainBuffer.getNumSamples();
+    if( silentInputSamples > tailSamples )
     {
-        auto delayTimeMs = apvts.getRawParameterValue("Delay Time")->load();
-        auto delayTimeSamples = static_cast<int>(getSampleRate() * delayTimeMs / 1000.0f);
-        delayLine.setDelay(delayTimeSamples);
-
-        auto feedback = apvts.getRawParameterValue("Delay Feedback")->load();
-        auto mix = apvts.getRawParameterValue("Delay Mix")->load();
-
-        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
-        {
-            auto* channelData = buffer.getWritePointer(channel);
-            for (int i = 0; i < buffer.getNumSamples(); ++i)
-            {
-                auto delayed = delayLine.popSample(0);
-                auto input = channelData[i];
-                delayLine.pushSample(0, input + delayed * feedback);
-                channelData[i] = input * (1.0f - mix) + delayed * mix;
-            }
-        }
+        mainBuffer.clear();
+        
+        // a preview being auditioned plays on without any input
+        if( ! candidateAudition.process(mainBuffer) )
+            return;
     }
-
-    /**========================
-     *   5. Reverb
-     *=========================*/
-    if (!apvts.getRawParameterValue("Reverb Bypassed")->load())
+    else
     {
-        juce::dsp::Reverb::Parameters params;
-        params.roomSize = apvts.getRawParameterValue("Reverb Size")->load();
-        params.wetLevel = apvts.getRawParameterValue("Reverb Mix")->load();
-        params.dryLevel = 1.0f - params.wetLevel;
-        params.damping  = juce::jlimit(0.0f, 1.0f, apvts.getRawParameterValue("Reverb Decay")->load() / 10.0f);
-        reverb.setParameters(params);
-
-        juce::dsp::ProcessContextReplacing<float> context(block);
-        reverb.process(context);
+        // the live chain keeps running under a preview, so switching back to it is seamless
+        juce::dsp::AudioBlock<SampleType> block(mainBuffer);
+        chain.process(block, getActiveStages(snapshot.settings), juce::dsp::AudioBlock<const SampleType>(sidechainBuffer));
+        candidateAudition.process(mainBuffer);
     }
 
     /**========================
      *   Final: FFT Visualization
      *=========================*/
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    leftChannelFifo.update(mainBuffer);
+    rightChannelFifo.update(mainBuffer);
 }
 
+int getActiveStages(const ChainSettings& chainSettings)
+{
+    int stages = 0;
+    
+    // in linear-phase mode the EQ stays in even when fully bypassed, to keep the latency constant
+    if( chainSettings.linearPhase || ! (chainSettings.lowCutBypassed && chainSettings.peakBypassed && chainSettings.highCutBypassed) )
+        stages |= ChainStages::EQStage;
+    if( ! chainSettings.compBypassed )
+        stages |= ChainStages::CompressorStage;
+    if( ! chainSettings.distortionBypassed )
+        stages |= ChainStages::DistortionStage;
+    if( ! chainSettings.delayBypassed && false ) // delay is still switched off
+        stages |= ChainStages::DelayStage;
+    if( ! chainSettings.reverbBypassed )
+        stages |= ChainStages::ReverbStage;
+    
+    return stages;
+}
 
 //==============================================================================
 bool SimpleEQAudioProcessor::hasEditor() const
@@ -283,118 +303,894 @@ void SimpleEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // as intermediaries to make it easy to save and load complex data.
     
     juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    writeBinaryState(mos);
 }
 
 void SimpleEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    if( readBinaryState(data, sizeInBytes) )
+    {
+        settingsChanged.store(true);
+        return;
+    }
+    
+    // sessions saved before the binary format
     auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
     if( tree.isValid() )
     {
         apvts.replaceState(tree);
-        updateSettings();
+        
+        // picked up by the next publishSettingsIfChanged(), on whichever thread gets there first
+        settingsChanged.store(true);
     }
 }
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+juce::String getChainParameterID(int chainParameter)
+{
+    static constexpr const char* ids[CompBandParameters] =
+    {
+        "LowCut Freq", "HighCut Freq", "Peak Freq", "Peak Gain", "Peak Quality", "LowCut Slope", "HighCut Slope",
+        "LowCut Bypassed", "Peak Bypassed", "HighCut Bypassed", "Linear Phase", "Linear Phase Length",
+        "Comp Threshold", "Comp Ratio", "Comp Attack", "Comp Release", "Comp Sidechain", "Comp Sidechain HighPass",
+        "Comp Multiband", "Comp Bands", "Comp Crossover Low", "Comp Crossover Mid", "Comp Crossover High",
+        "Distortion Amount", "Delay Time", "Delay Feedback", "Delay Mix", "Reverb Size", "Reverb Decay", "Reverb Mix",
+        "Comp Bypassed", "Distortion Bypassed", "Delay Bypassed", "Reverb Bypassed", "Chain Order",
+        "Morph Time", "Morph Position"
+    };
+    
+    static constexpr const char* bandIDs[NumCompBandParameters] = { "Threshold", "Ratio", "Attack", "Release" };
+    
+    jassert(juce::isPositiveAndBelow(chainParameter, numChainParameters));
+    if( chainParameter < CompBandParameters )
+        return ids[chainParameter];
+    
+    const auto band = (chainParameter - CompBandParameters) / NumCompBandParameters;
+    return "Comp Band" + juce::String(band + 1) + " " + bandIDs[(chainParameter - CompBandParameters) % NumCompBandParameters];
+}
+
+/*
+ builds the settings from any source of plain (denormalised) parameter values by ChainParameter,
+ so the same mapping serves both the live parameters and presets on their way in.
+ */
+template<typename ValueSource>
+ChainSettings makeChainSettings(ValueSource&& getValue)
 {
     ChainSettings settings;
     
-    settings.lowCutFreq = apvts.getRawParameterValue("LowCut Freq")->load();
-    settings.highCutFreq = apvts.getRawParameterValue("HighCut Freq")->load();
-    settings.peakFreq = apvts.getRawParameterValue("Peak Freq")->load();
-    settings.peakGainInDecibels = apvts.getRawParameterValue("Peak Gain")->load();
-    settings.peakQuality = apvts.getRawParameterValue("Peak Quality")->load();
-    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("LowCut Slope")->load());
-    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("HighCut Slope")->load());
+    settings.lowCutFreq = getValue(LowCutFreqParameter);
+    settings.highCutFreq = getValue(HighCutFreqParameter);
+    settings.peakFreq = getValue(PeakFreqParameter);
+    settings.peakGainInDecibels = getValue(PeakGainParameter);
+    settings.peakQuality = getValue(PeakQualityParameter);
+    settings.lowCutSlope = static_cast<Slope>(getValue(LowCutSlopeParameter));
+    settings.highCutSlope = static_cast<Slope>(getValue(HighCutSlopeParameter));
+    
+    settings.lowCutBypassed = getValue(LowCutBypassedParameter) > 0.5f;
+    settings.peakBypassed = getValue(PeakBypassedParameter) > 0.5f;
+    settings.highCutBypassed = getValue(HighCutBypassedParameter) > 0.5f;
+    
+    settings.linearPhase = getValue(LinearPhaseParameter) > 0.5f;
+    auto kernelSizeIndex = static_cast<int>(getValue(LinearPhaseLengthParameter));
+    settings.linearPhaseKernelSize = linearPhaseKernelSizes[(size_t)juce::jlimit(0, (int)linearPhaseKernelSizes.size() - 1, kernelSizeIndex)];
     
-    settings.lowCutBypassed = apvts.getRawParameterValue("LowCut Bypassed")->load() > 0.5f;
-    settings.peakBypassed = apvts.getRawParameterValue("Peak Bypassed")->load() > 0.5f;
-    settings.highCutBypassed = apvts.getRawParameterValue("HighCut Bypassed")->load() > 0.5f;
+    settings.compThreshold = getValue(CompThresholdParameter);
+    settings.compRatio = getValue(CompRatioParameter);
+    settings.compAttack = getValue(CompAttackParameter);
+    settings.compRelease = getValue(CompReleaseParameter);
+    
+    settings.compSidechain = getValue(CompSidechainParameter) > 0.5f;
+    settings.compSidechainHighPass = getValue(CompSidechainHighPassParameter);
+    
+    settings.compMultiband = getValue(CompMultibandParameter) > 0.5f;
+    settings.compBands = static_cast<int>(getValue(CompBandsParameter));
+    settings.compCrossoverLow = getValue(CompCrossoverLowParameter);
+    settings.compCrossoverMid = getValue(CompCrossoverMidParameter);
+    settings.compCrossoverHigh = getValue(CompCrossoverHighParameter);
+    
+    for( int band = 0; band < (int)settings.compBandSettings.size(); ++band )
+    {
+        const auto first = CompBandParameters + band * NumCompBandParameters;
+        auto& bandSettings = settings.compBandSettings[(size_t)band];
+        
+        bandSettings.threshold = getValue(first + CompBandThreshold);
+        bandSettings.ratio = getValue(first + CompBandRatio);
+        bandSettings.attack = getValue(first + CompBandAttack);
+        bandSettings.release = getValue(first + CompBandRelease);
+    }
+    
+    settings.distortionAmount = getValue(DistortionAmountParameter);
+    settings.delayTimeMs = getValue(DelayTimeParameter);
+    settings.delayFeedback = getValue(DelayFeedbackParameter);
+    settings.delayMix = getValue(DelayMixParameter);
+    settings.reverbSize = getValue(ReverbSizeParameter);
+    settings.reverbDecay = getValue(ReverbDecayParameter);
+    settings.reverbMix = getValue(ReverbMixParameter);
+    
+    settings.compBypassed = getValue(CompBypassedParameter) > 0.5f;
+    settings.distortionBypassed = getValue(DistortionBypassedParameter) > 0.5f;
+    settings.delayBypassed = getValue(DelayBypassedParameter) > 0.5f;
+    settings.reverbBypassed = getValue(ReverbBypassedParameter) > 0.5f;
+    
+    settings.chainOrder = static_cast<int>(getValue(ChainOrderParameter));
+    
+    settings.morphTimeSeconds = getValue(MorphTimeParameter);
+    settings.morphPosition = getValue(MorphPositionParameter);
     
     return settings;
 }
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    return makeChainSettings([&apvts](int chainParameter) { return apvts.getRawParameterValue(getChainParameterID(chainParameter))->load(); });
+}
+
+BiquadCoefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return BiquadCoefficients::fromArray(juce::dsp::IIR::ArrayCoefficients<double>::makePeakFilter(sampleRate,
+                                                                                                   chainSettings.peakFreq,
+                                                                                                   chainSettings.peakQuality,
+                                                                                                   juce::Decibels::decibelsToGain((double)chainSettings.peakGainInDecibels)));
+}
+
+/*
+ same sections FilterDesign::designIIR*HighOrderButterworthMethod produces for the even
+ orders we use, without allocating a ReferenceCountedArray of coefficients every time.
+ */
+CutCoefficients makeButterworthCutFilter(float frequency, double sampleRate, Slope slope, bool isHighPass)
+{
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<double>;
+    
+    CutCoefficients cut;
+    const int order = 2 * (slope + 1);
+    cut.numStages = order / 2;
+    
+    for( int i = 0; i < cut.numStages; ++i )
+    {
+        auto q = 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+        
+        cut.stages[i] = BiquadCoefficients::fromArray(isHighPass ? ArrayCoefficients::makeHighPass(sampleRate, frequency, q)
+                                                                 : ArrayCoefficients::makeLowPass(sampleRate, frequency, q));
+    }
+    
+    return cut;
+}
+
+CutCoefficients makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeButterworthCutFilter(chainSettings.lowCutFreq, sampleRate, chainSettings.lowCutSlope, true);
+}
+
+CutCoefficients makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate)
+{
+    return makeButterworthCutFilter(chainSettings.highCutFreq, sampleRate, chainSettings.highCutSlope, false);
+}
+
+double getReverbTailSeconds(const ChainSettings& chainSettings, double attenuationInDecibels)
+{
+    // juce::Reverb feeds its comb filters back with roomSize * 0.28 + 0.7. The longest comb
+    // (including the stereo spread) is 1640 samples at 44.1kHz and the reverb scales its
+    // tunings with the sample rate, so the decay time doesn't depend on it.
+    const auto combFeedback = chainSettings.reverbSize * 0.28 + 0.7;
+    const auto combSeconds = (1617.0 + 23.0) / 44100.0;
+    
+    // ...followed by four allpasses in series, each with a feedback of 0.5
+    const auto allPassSeconds = (556.0 + 441.0 + 341.0 + 225.0) / 44100.0;
+    
+    return combSeconds * attenuationInDecibels / (-20.0 * std::log10(combFeedback))
+         + allPassSeconds * attenuationInDecibels / (-20.0 * std::log10(0.5));
+}
+
+double getDelayTailSeconds(const ChainSettings& chainSettings, double attenuationInDecibels)
+{
+    const auto delaySeconds = chainSettings.delayTimeMs / 1000.0;
+    
+    if( chainSettings.delayFeedback <= 0.f )
+        return delaySeconds;
+    
+    const auto repeats = attenuationInDecibels / (-20.0 * std::log10((double)chainSettings.delayFeedback));
+    return delaySeconds * (1.0 + repeats);
+}
+
+double getCutFilterTailSamples(const CutCoefficients& cut, double attenuationInDecibels)
+{
+    double samples = 0.0;
+    
+    for( int stage = 0; stage < cut.numStages; ++stage )
+        samples += cut.stages[stage].getDecayInSamples(attenuationInDecibels);
+    
+    return samples;
+}
+
+double computeTailLengthSeconds(const ChainSnapshot& snapshot)
+{
+    // the stages run in series, so their tails add up
+    const auto& settings = snapshot.settings;
+    const auto stages = getActiveStages(settings);
+    const auto attenuation = -(double)silenceThresholdInDecibels;
+    
+    double eqSamples = 0.0;
+    
+    if( (stages & ChainStages::EQStage) != 0 && settings.linearPhase )
+    {
+        eqSamples = settings.linearPhaseKernelSize;
+    }
+    else if( (stages & ChainStages::EQStage) != 0 )
+    {
+        if( ! settings.lowCutBypassed )
+            eqSamples += getCutFilterTailSamples(snapshot.lowCut, attenuation);
+        if( ! settings.peakBypassed )
+            eqSamples += snapshot.peak.getDecayInSamples(attenuation);
+        if( ! settings.highCutBypassed )
+            eqSamples += getCutFilterTailSamples(snapshot.highCut, attenuation);
+    }
+    
+    auto seconds = eqSamples / snapshot.sampleRate;
+    
+    if( (stages & ChainStages::DelayStage) != 0 )
+        seconds += getDelayTailSeconds(settings, attenuation);
+    
+    if( (stages & ChainStages::ReverbStage) != 0 )
+        seconds += getReverbTailSeconds(settings, attenuation);
+    
+    return seconds;
+}
+
+ChainSnapshot makeChainSnapshot(const ChainSettings& chainSettings, double sampleRate)
+{
+    ChainSnapshot snapshot;
+    snapshot.settings = chainSettings;
+    
+    // the editor can ask for a snapshot before the host has told us the sample rate
+    snapshot.sampleRate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    
+    snapshot.peak = makePeakFilter(chainSettings, snapshot.sampleRate);
+    snapshot.lowCut = makeLowCutFilter(chainSettings, snapshot.sampleRate);
+    snapshot.highCut = makeHighCutFilter(chainSettings, snapshot.sampleRate);
+    
+    snapshot.tailSeconds = computeTailLengthSeconds(snapshot);
+    
+    return snapshot;
+}
+
+void SimpleEQAudioProcessor::parameterValueChanged(int parameterIndex, float newValue)
+{
+    settingsChanged.store(true);
+}
+
+void SimpleEQAudioProcessor::parameterGestureChanged(int parameterIndex, bool gestureIsStarting)
+{
+    // hosts may report automation gestures from other threads; only the user's edits are undoable
+    if( notifyingHost || ! juce::MessageManager::existsAndIsCurrentThread() )
+        return;
+    
+    if( gestureIsStarting )
+    {
+        if( ! gestureStartValues.has(parameterIndex) )
+            gestureStartValues.set(parameterIndex, getPlainValue(parameterIndex));
+        
+        ++openGestures;
+        return;
+    }
+    
+    if( openGestures == 0 || --openGestures > 0 )
+        return;
+    
+    ParameterHistory::Entry entry;
+    const auto& parameters = getParameters();
+    
+    for( int index = 0; index < parameters.size(); ++index )
+    {
+        if( ! gestureStartValues.has(index) )
+            continue;
+        
+        auto before = gestureStartValues.get(index);
+        auto after = getPlainValue(index);
+        
+        if( before != after )
+            entry.changes.push_back({ (juce::uint16)index, before, after });
+    }
+    
+    if( entry.changes.size() == 1 )
+        entry.description = "Changed " + parameters[entry.changes.front().index]->getName(64);
+    else
+        entry.description = "Changed " + juce::String((int)entry.changes.size()) + " parameters";
+    
+    history.push(std::move(entry));
+    gestureStartValues = {};
+}
+
+bool SimpleEQAudioProcessor::publishSettingsIfChanged()
+{
+    const juce::SpinLock::ScopedTryLockType lock(publishLock);
+    
+    // the parameters only hold part of the preset the audio thread is running until the timer catches up
+    if( ! lock.isLocked() || ! settingsChanged.load() || presetsInFlight.load() > 0 )
+        return false;
+    
+    publishSettings();
+    return true;
+}
+
+void SimpleEQAudioProcessor::publishSettings()
+{
+    // cleared before reading, so a change that lands mid-design triggers another publish
+    settingsChanged.store(false);
+    
+    const auto sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    const auto presetSlot = presetsInFlight.load() > 0 ? inFlightPreset.slot : -1;
+    
+    ChainSnapshot snapshot;
+    bool designed = false;
+    
+    // a recalled slot was designed when it was stored, unless the sample rate has changed since
+    if( juce::isPositiveAndBelow(presetSlot, numSnapshotSlots) )
+    {
+        snapshot = slotSnapshots[(size_t)presetSlot].read();
+        designed = snapshot.sampleRate == sampleRate;
+    }
+    
+    if( ! designed )
+    {
+        const auto settings = presetsInFlight.load() > 0 ? getChainSettings(inFlightPreset) : getLiveChainSettings();
+        snapshot = makeChainSnapshot(settings, sampleRate);
+    }
+    
+    snapshot.generation = ++publishedGeneration;
+    snapshot.morphId = morphGeneration;
+    
+    chainSnapshots.publish(snapshot);
+    
+    // the chains switch EQ mode on this snapshot, so the host has to hear about it now, not once the kernel is built
+    const auto latency = snapshot.settings.linearPhase ? floatChain.getLinearPhaseLatency(snapshot.settings.linearPhaseKernelSize) : 0;
+    if( latency != getLatencySamples() )
+        setLatencySamples(latency);
+}
+
+ChainSettings SimpleEQAudioProcessor::getChainSettings(const ParameterPreset& preset)
+{
+    return makeChainSettings([this, &preset](int chainParameter)
+    {
+        auto index = chainParameterIndices[(size_t)chainParameter];
+        return preset.has(index) ? preset.get(index) : chainParameterValues[(size_t)chainParameter]->load();
+    });
+}
+
+ChainSettings SimpleEQAudioProcessor::getLiveChainSettings() const
+{
+    return makeChainSettings([this](int chainParameter) { return chainParameterValues[(size_t)chainParameter]->load(); });
+}
+
+void SimpleEQAudioProcessor::pullPresetCommands()
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               chainSettings.peakFreq,
-                                                               chainSettings.peakQuality,
-                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels));
+    // call with publishLock held: the timer drains the queue too while no blocks are coming
+    ParameterPreset preset;
+    while( presetCommands.pull(preset) )
+    {
+        pendingPreset.mergeFrom(preset);
+        hasPendingPreset = true;
+    }
 }
 
-void SimpleEQAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+void SimpleEQAudioProcessor::applyPendingPresets()
 {
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
+    // if the editor is publishing right now, the preset goes in with the next block instead
+    const juce::SpinLock::ScopedTryLockType lock(publishLock);
+    if( ! lock.isLocked() )
+        return;
+    
+    // only the combination of everything queued so far matters
+    pullPresetCommands();
+    
+    if( ! hasPendingPreset )
+        return;
+    
+    // counted before it's queued, so the timer can never take the count below zero
+    if( presetsInFlight.fetch_add(1) == 0 )
+        inFlightPreset = {};
+    
+    if( ! presetNotifications.push(pendingPreset) )
+    {
+        --presetsInFlight;
+        return;
+    }
     
-    leftChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
-    rightChain.setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    inFlightPreset.mergeFrom(pendingPreset);
     
-    updateCoefficients(leftChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    if( pendingPreset.morph )
+        ++morphGeneration;
+    
+    pendingPreset = {};
+    hasPendingPreset = false;
+    
+    publishSettings();
 }
 
-void updateCoefficients(Coefficients &old, const Coefficients &replacements)
+void SimpleEQAudioProcessor::timerCallback()
 {
-    *old = *replacements;
+    // tells the host about the presets the audio thread has switched to, all in one go
+    ParameterPreset preset;
+    int notified = 0;
+    
+    while( presetNotifications.pull(preset) )
+    {
+        notifyHost(preset);
+        ++notified;
+    }
+    
+    if( notified > 0 )
+    {
+        presetsInFlight -= notified;
+        settingsChanged.store(true);
+    }
+    
+    if( presetCommands.getNumAvailableForReading() > 0 && isAudioThreadIdle() )
+        applyPendingPresetsHere();
+    
+    // the kernel builder's thread only starts once linear phase is first used, and only wakes for a new snapshot
+    const auto snapshot = getChainSnapshot();
+    if( snapshot.generation != kernelCheckedGeneration )
+    {
+        kernelCheckedGeneration = snapshot.generation;
+        
+        if( snapshot.settings.linearPhase && ! kernelBuilder.isThreadRunning() )
+            kernelBuilder.startThread();
+        
+        kernelBuilder.notify();
+    }
+    
+    // once the audio thread has caught up, the parameters themselves are where new diffs start from
+    if( presetsInFlight.load() == 0 && presetCommands.getNumAvailableForReading() == 0 )
+        requestedPreset = {};
 }
 
-void SimpleEQAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings)
+void SimpleEQAudioProcessor::notifyHost(const ParameterPreset& preset)
 {
-    auto cutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
+    const auto& parameters = getParameters();
+    const juce::ScopedValueSetter<bool> notifying(notifyingHost, true);
     
-    leftChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
-    rightChain.setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    for( int index = 0; index < parameters.size(); ++index )
+    {
+        auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(parameters[index]);
+        if( ! preset.has(index) || parameter == nullptr )
+            continue;
+        
+        auto normalised = parameter->convertTo0to1(preset.get(index));
+        if( juce::approximatelyEqual(parameter->getValue(), normalised) )
+            continue;
+        
+        parameter->beginChangeGesture();
+        parameter->setValueNotifyingHost(normalised);
+        parameter->endChangeGesture();
+    }
+}
+
+bool SimpleEQAudioProcessor::isAudioThreadIdle() const
+{
+    // a couple of block periods, but never so little that an ordinary scheduling hiccup counts
+    const auto blockMs = getSampleRate() > 0.0 ? 1000.0 * getBlockSize() / getSampleRate() : 0.0;
+    const auto idleMs = juce::jmax(minimumIdleMs, (juce::uint32)(2.0 * blockMs));
     
-    updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(leftLowCut, cutCoefficients, chainSettings.lowCutSlope);
+    return juce::Time::getMillisecondCounter() - lastBlockTime.load() > idleMs;
 }
 
-void SimpleEQAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings)
+void SimpleEQAudioProcessor::applyPendingPresetsHere()
 {
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
+    /*
+     with the transport stopped, the plugin bypassed or an offline render over, no block comes
+     along to pick the queue up, so the parameters are set from here instead. The audio thread
+     picks them up like any other change once it runs again.
+     */
+    ParameterPreset preset;
     
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
+    {
+        const juce::SpinLock::ScopedLockType lock(publishLock);
+        pullPresetCommands();
+        
+        if( ! hasPendingPreset )
+            return;
+        
+        preset = pendingPreset;
+        pendingPreset = {};
+        hasPendingPreset = false;
+        
+        if( preset.morph )
+            ++morphGeneration;
+    }
     
-    leftChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
-    rightChain.setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    notifyHost(preset);
+    settingsChanged.store(true);
+}
+
+//==============================================================================
+bool SimpleEQAudioProcessor::applyPreset(const ParameterPreset& preset)
+{
+    if( ! presetCommands.push(preset) )
+        return false;
     
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
+    requestedPreset.mergeFrom(preset);
+    return true;
 }
 
-void SimpleEQAudioProcessor::updateSettings()
+bool SimpleEQAudioProcessor::applyPreset(const ParameterPreset& preset, const juce::String& description)
 {
-    auto chainSettings = getChainSettings(apvts);
+    ParameterHistory::Entry entry;
+    entry.description = description;
+    
+    const auto& parameters = getParameters();
+    for( int index = 0; index < parameters.size(); ++index )
+    {
+        auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(parameters[index]);
+        if( ! preset.has(index) || parameter == nullptr )
+            continue;
+        
+        // compared the way the parameter will store it, so out-of-range and unsnapped values aren't 'changes'
+        auto before = getPlainValue(index);
+        auto after = parameter->convertFrom0to1(parameter->convertTo0to1(preset.get(index)));
+        
+        if( before != after )
+            entry.changes.push_back({ (juce::uint16)index, before, after });
+    }
     
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
-    updateCompressorSettings();
-    updateDistortionSettings();
-    updateDelaySettings();
-    updateReverbSettings();
+    if( ! applyPreset(preset) )
+        return false;
+    
+    if( stepIsOpen )
+        ParameterHistory::merge(openStep, entry);
+    else
+        history.push(std::move(entry));
+    
+    return true;
 }
 
-void SimpleEQAudioProcessor::updateCompressorSettings() {
-    compressor.setThreshold(apvts.getRawParameterValue("Comp Threshold")->load());
-    compressor.setRatio(apvts.getRawParameterValue("Comp Ratio")->load());
-    compressor.setAttack(apvts.getRawParameterValue("Comp Attack")->load());
-    compressor.setRelease(apvts.getRawParameterValue("Comp Release")->load());
+void SimpleEQAudioProcessor::beginHistoryStep(const juce::String& description)
+{
+    endHistoryStep();
+    
+    openStep = {};
+    openStep.description = description;
+    stepIsOpen = true;
 }
 
-void SimpleEQAudioProcessor::updateDistortionSettings() {
+void SimpleEQAudioProcessor::endHistoryStep()
+{
+    if( ! stepIsOpen )
+        return;
+    
+    history.push(std::move(openStep));
+    openStep = {};
+    stepIsOpen = false;
+}
+
+bool SimpleEQAudioProcessor::undo()
+{
+    if( ! history.canUndo() || presetCommands.getNumAvailableForReading() > 0 )
+        return false;
+    
+    applyHistoryEntry(*history.undo(), false);
+    return true;
+}
+
+bool SimpleEQAudioProcessor::redo()
+{
+    if( ! history.canRedo() || presetCommands.getNumAvailableForReading() > 0 )
+        return false;
+    
+    applyHistoryEntry(*history.redo(), true);
+    return true;
+}
+
+void SimpleEQAudioProcessor::applyHistoryEntry(const ParameterHistory::Entry& entry, bool forwards)
+{
+    ParameterPreset preset;
+    
+    for( const auto& change : entry.changes )
+        preset.set(change.index, forwards ? change.after : change.before);
+    
+    // can't fail, the queue was just checked to be empty
+    applyPreset(preset);
+}
+
+float SimpleEQAudioProcessor::getPlainValue(int parameterIndex) const
+{
+    if( requestedPreset.has(parameterIndex) )
+        return requestedPreset.get(parameterIndex);
+    
+    auto* parameter = dynamic_cast<juce::RangedAudioParameter*>(getParameters()[parameterIndex]);
+    return parameter != nullptr ? parameter->convertFrom0to1(parameter->getValue()) : 0.f;
 }
 
-void SimpleEQAudioProcessor::updateDelaySettings() {
+//==============================================================================
+void SimpleEQAudioProcessor::storeSnapshotSlot(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSnapshotSlots));
+    if( ! juce::isPositiveAndBelow(slot, numSnapshotSlots) )
+        return;
+    
+    const juce::ScopedLock lock(slotLock);
+    
+    auto& snapshotSlot = snapshotSlots[(size_t)slot];
+    snapshotSlot.preset = {};
+    snapshotSlot.preset.slot = slot;
+    
+    for( auto* param : getParameters() )
+        if( auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param) )
+            snapshotSlot.preset.set(param->getParameterIndex(), ranged->convertFrom0to1(ranged->getValue()));
+    
+    snapshotSlot.stored = true;
+    activeSnapshotSlot = slot;
+    
+    designSnapshotSlot(slot);
 }
 
-void SimpleEQAudioProcessor::updateReverbSettings() {
+bool SimpleEQAudioProcessor::recallSnapshotSlot(int slot)
+{
+    if( ! isSnapshotSlotStored(slot) )
+        return false;
+    
+    const juce::ScopedLock lock(slotLock);
+    
+    auto description = "Recall slot " + juce::String::charToString(juce::juce_wchar('A' + slot));
+    if( ! applyPreset(snapshotSlots[(size_t)slot].preset, description) )
+        return false;
+    
+    activeSnapshotSlot = slot;
+    return true;
+}
+
+bool SimpleEQAudioProcessor::isSnapshotSlotStored(int slot) const
+{
+    const juce::ScopedLock lock(slotLock);
+    return juce::isPositiveAndBelow(slot, numSnapshotSlots) && snapshotSlots[(size_t)slot].stored;
+}
+
+void SimpleEQAudioProcessor::designSnapshotSlot(int slot)
+{
+    // call with slotLock held
+    const auto sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    const auto& preset = snapshotSlots[(size_t)slot].preset;
+    
+    slotSnapshots[(size_t)slot].publish(makeChainSnapshot(getChainSettings(preset), sampleRate));
+}
+
+void SimpleEQAudioProcessor::updateSnapshotSlotsForSampleRate()
+{
+    const auto sampleRate = getSampleRate() > 0.0 ? getSampleRate() : 44100.0;
+    const juce::ScopedLock lock(slotLock);
+    
+    for( int slot = 0; slot < numSnapshotSlots; ++slot )
+        if( snapshotSlots[(size_t)slot].stored && slotSnapshots[(size_t)slot].read().sampleRate != sampleRate )
+            designSnapshotSlot(slot);
+}
+
+void SimpleEQAudioProcessor::writeBinaryState(juce::OutputStream& stream)
+{
+    const auto& parameters = getParameters();
+    
+    auto writeValues = [&parameters](juce::OutputStream& out, auto&& getValue)
+    {
+        for( int index = 0; index < parameters.size(); ++index )
+            out.writeFloat(getValue(index));
+    };
+    
+    auto writeChunk = [&stream](StateChunk tag, const juce::MemoryOutputStream& chunk)
+    {
+        stream.writeInt(tag);
+        stream.writeInt((int)chunk.getDataSize());
+        stream.write(chunk.getData(), chunk.getDataSize());
+    };
+    
+    stream.writeInt(stateMagic);
+    stream.writeShort(stateVersion);
+    
+    {
+        juce::MemoryOutputStream chunk;
+        chunk.writeInt((int)parameterLayoutHash);
+        chunk.writeShort((short)parameters.size());
+        writeValues(chunk, [&parameters](int index)
+        {
+            auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[index]);
+            return ranged != nullptr ? ranged->convertFrom0to1(ranged->getValue()) : 0.f;
+        });
+        writeChunk(ParameterValuesChunk, chunk);
+    }
+    
+    {
+        juce::MemoryOutputStream chunk;
+        for( auto* param : parameters )
+        {
+            auto* paramWithID = dynamic_cast<juce::AudioProcessorParameterWithID*>(param);
+            chunk.writeInt(paramWithID != nullptr ? paramWithID->paramID.hashCode() : 0);
+        }
+        writeChunk(ParameterIDsChunk, chunk);
+    }
+    
+    {
+        const juce::ScopedLock lock(slotLock);
+        
+        juce::MemoryOutputStream chunk;
+        chunk.writeByte((char)activeSnapshotSlot);
+        
+        for( int slot = 0; slot < numSnapshotSlots; ++slot )
+        {
+            const auto& snapshotSlot = snapshotSlots[(size_t)slot];
+            if( ! snapshotSlot.stored )
+                continue;
+            
+            chunk.writeByte((char)slot);
+            writeValues(chunk, [&snapshotSlot](int index) { return snapshotSlot.preset.get(index); });
+        }
+        
+        writeChunk(SnapshotSlotsChunk, chunk);
+    }
+    
+    auto transcript = getChatTranscript();
+    if( transcript.isNotEmpty() )
+    {
+        juce::MemoryOutputStream chunk;
+        {
+            juce::GZIPCompressorOutputStream zipper(chunk);
+            zipper.writeString(transcript);
+        }
+        writeChunk(ChatTranscriptChunk, chunk);
+    }
+}
+
+bool SimpleEQAudioProcessor::readBinaryState(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, (size_t)juce::jmax(0, sizeInBytes), false);
+    
+    if( sizeInBytes < 6 || stream.readInt() != stateMagic )
+        return false;
+    
+    // a newer build may have changed what a chunk holds, so its sessions aren't guessed at
+    const auto version = (int)stream.readShort();
+    if( version < 1 || version > stateVersion )
+        return false;
+    
+    const auto& parameters = getParameters();
+    
+    juce::MemoryBlock values, idHashes, slots, transcript;
+    int numSavedParameters = 0;
+    bool sameLayout = false;
+    
+    while( stream.getNumBytesRemaining() >= 8 )
+    {
+        const auto tag = stream.readInt();
+        const auto size = stream.readInt();
+        
+        if( size < 0 || size > stream.getNumBytesRemaining() )
+            return false;
+        
+        juce::MemoryBlock chunk;
+        stream.readIntoMemoryBlock(chunk, size);
+        
+        switch( tag )
+        {
+            case ParameterValuesChunk:
+            {
+                juce::MemoryInputStream header(chunk, false);
+                sameLayout = (juce::uint32)header.readInt() == parameterLayoutHash;
+                numSavedParameters = juce::jmax(0, (int)header.readShort());
+                values = chunk;
+                break;
+            }
+            case ParameterIDsChunk: idHashes = chunk; break;
+            case SnapshotSlotsChunk: slots = chunk; break;
+            case ChatTranscriptChunk: transcript = chunk; break;
+            default: break;
+        }
+    }
+    
+    // a truncated or padded chunk would shift every value after the damage, so it's rejected outright.
+    // The IDs are only needed to map another layout onto this one.
+    if( values.getSize() != 6 + (size_t)numSavedParameters * 4
+        || ( ! sameLayout && idHashes.getSize() != (size_t)numSavedParameters * 4) )
+    {
+        return false;
+    }
+    
+    // saved position -> current index: the same layout needs no lookup, any other one goes by ID hash
+    std::vector<int> indexMap((size_t)numSavedParameters, -1);
+    for( int saved = 0; saved < numSavedParameters; ++saved )
+    {
+        if( sameLayout )
+        {
+            indexMap[(size_t)saved] = saved < parameters.size() ? saved : -1;
+            continue;
+        }
+        
+        auto idHash = (juce::uint32)juce::ByteOrder::littleEndianInt(static_cast<const char*>(idHashes.getData()) + saved * 4);
+        indexMap[(size_t)saved] = parameterIndicesByHash.contains(idHash) ? parameterIndicesByHash[idHash] : -1;
+    }
+    
+    // anything the session doesn't mention goes back to its default
+    auto readValues = [&](juce::InputStream& in)
+    {
+        ParameterPreset preset;
+        
+        for( auto* param : parameters )
+            if( auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param) )
+                preset.set(param->getParameterIndex(), ranged->convertFrom0to1(ranged->getDefaultValue()));
+        
+        for( auto index : indexMap )
+        {
+            auto value = in.readFloat();
+            if( index >= 0 )
+                preset.set(index, value);
+        }
+        
+        return preset;
+    };
+    
+    juce::MemoryInputStream valueStream(values, false);
+    valueStream.skipNextBytes(6);
+    const auto restored = readValues(valueStream);
+    
+    // straight onto the parameters, which keep the APVTS tree up to date themselves
+    for( int index = 0; index < parameters.size(); ++index )
+        if( auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameters[index]) )
+            ranged->setValueNotifyingHost(ranged->convertTo0to1(restored.get(index)));
+    
+    {
+        const juce::ScopedLock lock(slotLock);
+        
+        for( auto& snapshotSlot : snapshotSlots )
+            snapshotSlot = {};
+        
+        juce::MemoryInputStream slotStream(slots, false);
+        activeSnapshotSlot = slots.isEmpty() ? 0 : juce::jlimit(0, numSnapshotSlots - 1, (int)slotStream.readByte());
+        
+        const auto slotSize = 1 + (juce::int64)numSavedParameters * 4;
+        while( slotStream.getNumBytesRemaining() >= slotSize )
+        {
+            const int slot = slotStream.readByte();
+            auto preset = readValues(slotStream);
+            
+            if( ! juce::isPositiveAndBelow(slot, numSnapshotSlots) )
+                continue;
+            
+            auto& snapshotSlot = snapshotSlots[(size_t)slot];
+            snapshotSlot.preset = preset;
+            snapshotSlot.preset.slot = slot;
+            snapshotSlot.stored = true;
+            designSnapshotSlot(slot);
+        }
+    }
+    
+    juce::String restoredTranscript;
+    if( ! transcript.isEmpty() )
+    {
+        juce::MemoryInputStream compressed(transcript, false);
+        juce::GZIPDecompressorInputStream unzipper(compressed);
+        restoredTranscript = unzipper.readString();
+    }
+    
+    setChatTranscript(restoredTranscript);
+    return true;
+}
+
+void SimpleEQAudioProcessor::setChatTranscript(const juce::String& transcript)
+{
+    const juce::ScopedLock lock(transcriptLock);
+    chatTranscript = transcript;
+}
+
+juce::String SimpleEQAudioProcessor::getChatTranscript() const
+{
+    const juce::ScopedLock lock(transcriptLock);
+    return chatTranscript;
+}
+
+void SimpleEQAudioProcessor::applyLinearPhaseKernel(const ChainSnapshot& snapshot, const juce::AudioBuffer<float>& kernel)
+{
+    // called on the kernel builder's thread
+    if( kernel.getNumSamples() > 0 )
+    {
+        floatChain.loadLinearPhaseKernel(kernel, snapshot.sampleRate);
+        doubleChain.loadLinearPhaseKernel(kernel, snapshot.sampleRate);
+    }
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::createParameterLayout()
@@ -442,6 +1238,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "HighCut Bypassed", 1 }, "HighCut Bypassed", false));
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Analyzer Enabled", 1 }, "Analyzer Enabled", true));
     
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Linear Phase", 1 }, "Linear Phase", false));
+    
+    juce::StringArray kernelSizes;
+    for( auto size : linearPhaseKernelSizes )
+        kernelSizes.add(juce::String(size) + " taps");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "Linear Phase Length", 1 }, "Linear Phase Length", kernelSizes, 2));
+    
     /* COMPRESSOR */
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Comp Threshold", 1 }, "Comp Threshold",
         juce::NormalisableRange<float>(-60.f, 0.f, 1.f), -24.f));
@@ -453,6 +1257,35 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
         juce::NormalisableRange<float>(10.f, 500.f, 0.1f), 250.f));
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Comp Bypassed", 1 }, "Comp Bypassed", false));
     
+    /* SIDECHAIN */
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Comp Sidechain", 1 }, "Comp Sidechain", false));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Comp Sidechain HighPass", 1 }, "Comp Sidechain HighPass",
+        juce::NormalisableRange<float>(20.f, 2000.f, 1.f, 0.3f), 20.f));
+    
+    /* MULTIBAND COMPRESSOR */
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Comp Multiband", 1 }, "Comp Multiband", false));
+    layout.add(std::make_unique<juce::AudioParameterInt>(juce::ParameterID { "Comp Bands", 1 }, "Comp Bands", 3, 4, 3));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Comp Crossover Low", 1 }, "Comp Crossover Low",
+        juce::NormalisableRange<float>(20.f, 1000.f, 1.f, 0.4f), 150.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Comp Crossover Mid", 1 }, "Comp Crossover Mid",
+        juce::NormalisableRange<float>(200.f, 5000.f, 1.f, 0.4f), 1500.f));
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Comp Crossover High", 1 }, "Comp Crossover High",
+        juce::NormalisableRange<float>(1000.f, 16000.f, 1.f, 0.4f), 6000.f));
+    
+    for( int band = 1; band <= 4; ++band )
+    {
+        auto prefix = "Comp Band" + juce::String(band) + " ";
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { prefix + "Threshold", 1 }, prefix + "Threshold",
+            juce::NormalisableRange<float>(-60.f, 0.f, 1.f), -24.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { prefix + "Ratio", 1 }, prefix + "Ratio",
+            juce::NormalisableRange<float>(1.f, 20.f, 0.1f), 2.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { prefix + "Attack", 1 }, prefix + "Attack",
+            juce::NormalisableRange<float>(1.f, 100.f, 0.1f), 20.f));
+        layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { prefix + "Release", 1 }, prefix + "Release",
+            juce::NormalisableRange<float>(10.f, 500.f, 0.1f), 250.f));
+    }
+    
     /* DISTORTION */
     layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Distortion Amount", 1 }, "Distortion Amount",
         juce::NormalisableRange<float>(1.f, 10.f, 0.1f), 1.0f));
@@ -476,6 +1309,19 @@ juce::AudioProcessorValueTreeState::ParameterLayout SimpleEQAudioProcessor::crea
         juce::NormalisableRange<float>(0.f, 1.f, 0.01f), 0.3f));
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID { "Reverb Bypassed", 1 }, "Reverb Bypassed", false));
     
+    /* CHAIN ORDER */
+    juce::StringArray chainOrders;
+    for( int order = 0; order < numChainOrders; ++order )
+        chainOrders.add(getChainOrderName(order));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>(juce::ParameterID { "Chain Order", 1 }, "Chain Order", chainOrders, 0));
+    
+    /* MORPHING */
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Morph Time", 1 }, "Morph Time",
+        juce::NormalisableRange<float>(0.f, 10.f, 0.01f, 0.5f), 2.f)); // in seconds
+    layout.add(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID { "Morph Position", 1 }, "Morph Position",
+        juce::NormalisableRange<float>(0.f, 1.f, 0.001f), 1.f));
+    
     return layout;
 }
 
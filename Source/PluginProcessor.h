@@ -11,6 +11,12 @@
 #include <JuceHeader.h>
 #include <functional>
 #include <array>
+#include "ChainSnapshot.h"
+#include "ProcessingChain.h"
+#include "LinearPhaseEQ.h"
+#include "ParameterHistory.h"
+#include "CandidatePreviews.h"
+
 template<typename T>
 struct Fifo
 {
@@ -88,15 +94,19 @@ struct SingleChannelSampleFifo
         prepared.set(false);
     }
     
-    void update(const BlockType& buffer)
+    template<typename BufferType>
+    void update(const BufferType& buffer)
     {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse );
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        jassert(buffer.getNumChannels() > 0);
+        
+        // the tap may point past the end of a narrower bus, so fall back to the last channel
+        auto channel = juce::jmin(channelToUse.get(), buffer.getNumChannels() - 1);
+        auto* channelPtr = buffer.getReadPointer(channel);
         
         for( int i = 0; i < buffer.getNumSamples(); ++i )
         {
-            pushNextSampleIntoFifo(channelPtr[i]);
+            pushNextSampleIntoFifo(static_cast<float>(channelPtr[i]));
         }
     }
 
@@ -119,9 +129,13 @@ struct SingleChannelSampleFifo
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
     //==============================================================================
+    // which bus channel the analyzer listens to, safe to change while audio is running
+    void setChannelToUse(int channel) { channelToUse.set(juce::jlimit(0, maxChannels - 1, channel)); }
+    int getChannelToUse() const { return channelToUse.get(); }
+    //==============================================================================
     bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }
 private:
-    Channel channelToUse;
+    juce::Atomic<int> channelToUse;
     int fifoIndex = 0;
     Fifo<BlockType> audioBufferFifo;
     BlockType bufferToFill;
@@ -144,99 +158,125 @@ private:
     }
 };
 
-enum Slope
-{
-    Slope_12,
-    Slope_24,
-    Slope_36,
-    Slope_48
-};
-
-struct ChainSettings
+/**
+ A full or partial set of plain (denormalised) parameter values, indexed like getParameters().
+ Fixed size and trivially copyable, so whole presets can travel through a Fifo.
+ */
+struct ParameterPreset
 {
-    float peakFreq { 0 }, peakGainInDecibels{ 0 }, peakQuality {1.f};
-    float lowCutFreq { 0 }, highCutFreq { 0 };
+    static constexpr int maxParameters = 128;
+    
+    void set(int index, float value)
+    {
+        jassert(juce::isPositiveAndBelow(index, maxParameters));
+        if( juce::isPositiveAndBelow(index, maxParameters) )
+        {
+            values[(size_t)index] = value;
+            isSet[(size_t)index] = true;
+        }
+    }
+    
+    bool has(int index) const { return juce::isPositiveAndBelow(index, maxParameters) && isSet[(size_t)index]; }
+    float get(int index) const { return values[(size_t)index]; }
     
-    Slope lowCutSlope { Slope::Slope_12 }, highCutSlope { Slope::Slope_12 };
+    // glide to this preset over the "Morph Time" rather than jumping
+    bool morph = false;
     
-    bool lowCutBypassed { false }, peakBypassed { false }, highCutBypassed { false };
+    // the snapshot slot this (complete) preset was recalled from, whose coefficients are already designed
+    int slot = -1;
+    
+    void mergeFrom(const ParameterPreset& other)
+    {
+        morph = morph || other.morph;
+        slot = other.slot;
+        
+        for( int index = 0; index < maxParameters; ++index )
+            if( other.has(index) )
+                set(index, other.get(index));
+    }
+private:
+    std::array<float, maxParameters> values {};
+    std::array<bool, maxParameters> isSet {};
 };
 
-ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
-
-using Filter = juce::dsp::IIR::Filter<float>;
-
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
-
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+/*
+ every parameter ChainSettings is built from, so the processor can resolve them once rather than
+ looking each one up by ID whenever the settings are rebuilt. The compressor bands come last,
+ NumCompBandParameters of them per band.
+ */
+enum ChainParameter
+{
+    LowCutFreqParameter,
+    HighCutFreqParameter,
+    PeakFreqParameter,
+    PeakGainParameter,
+    PeakQualityParameter,
+    LowCutSlopeParameter,
+    HighCutSlopeParameter,
+    LowCutBypassedParameter,
+    PeakBypassedParameter,
+    HighCutBypassedParameter,
+    LinearPhaseParameter,
+    LinearPhaseLengthParameter,
+    CompThresholdParameter,
+    CompRatioParameter,
+    CompAttackParameter,
+    CompReleaseParameter,
+    CompSidechainParameter,
+    CompSidechainHighPassParameter,
+    CompMultibandParameter,
+    CompBandsParameter,
+    CompCrossoverLowParameter,
+    CompCrossoverMidParameter,
+    CompCrossoverHighParameter,
+    DistortionAmountParameter,
+    DelayTimeParameter,
+    DelayFeedbackParameter,
+    DelayMixParameter,
+    ReverbSizeParameter,
+    ReverbDecayParameter,
+    ReverbMixParameter,
+    CompBypassedParameter,
+    DistortionBypassedParameter,
+    DelayBypassedParameter,
+    ReverbBypassedParameter,
+    ChainOrderParameter,
+    MorphTimeParameter,
+    MorphPositionParameter,
+    CompBandParameters
+};
 
-enum ChainPositions
+enum CompBandParameter
 {
-    LowCut,
-    Peak,
-    HighCut
+    CompBandThreshold,
+    CompBandRatio,
+    CompBandAttack,
+    CompBandRelease,
+    NumCompBandParameters
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+constexpr int numChainParameters = CompBandParameters + NumCompBandParameters * (int)std::tuple_size<decltype(ChainSettings::compBandSettings)>::value;
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate);
+juce::String getChainParameterID(int chainParameter);
 
-template<int Index, typename ChainType, typename CoefficientType>
-void update(ChainType& chain, const CoefficientType& coefficients)
-{
-    updateCoefficients(chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
+ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
-template<typename ChainType, typename CoefficientType>
-void updateCutFilter(ChainType& chain,
-                     const CoefficientType& coefficients,
-                     const Slope& slope)
-{
-    chain.template setBypassed<0>(true);
-    chain.template setBypassed<1>(true);
-    chain.template setBypassed<2>(true);
-    chain.template setBypassed<3>(true);
-    
-    switch( slope )
-    {
-        case Slope_48:
-        {
-            update<3>(chain, coefficients);
-        }
-        case Slope_36:
-        {
-            update<2>(chain, coefficients);
-        }
-        case Slope_24:
-        {
-            update<1>(chain, coefficients);
-        }
-        case Slope_12:
-        {
-            update<0>(chain, coefficients);
-        }
-    }
-}
+/*
+ the tail is measured down to the level we treat as silence on the input, so once
+ that much time has passed without input the output is silent too.
+ */
+constexpr float silenceThresholdInDecibels = -90.f;
 
-inline auto makeLowCutFilter(const ChainSettings& chainSettings, double sampleRate )
-{
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                       sampleRate,
-                                                                                       2 * (chainSettings.lowCutSlope + 1));
-}
+double computeTailLengthSeconds(const ChainSnapshot& snapshot);
+
+ChainSnapshot makeChainSnapshot(const ChainSettings& chainSettings, double sampleRate);
 
-inline auto makeHighCutFilter(const ChainSettings& chainSettings, double sampleRate )
-{
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                      sampleRate,
-                                                                                      2 * (chainSettings.highCutSlope + 1));
-}
 //==============================================================================
 /**
 */
-class SimpleEQAudioProcessor  : public juce::AudioProcessor
+class SimpleEQAudioProcessor  : public juce::AudioProcessor,
+                                public juce::AudioProcessorParameter::Listener,
+                                private juce::Timer
 {
 public:
     //==============================================================================
@@ -252,6 +292,10 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    
+    // high-Q, low frequency peaks hold up noticeably better with double precision state
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -276,37 +320,187 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    void parameterValueChanged (int parameterIndex, float newValue) override;
+    void parameterGestureChanged (int parameterIndex, bool gestureIsStarting) override;
+
+    /*
+     designs and publishes a new ChainSnapshot if any parameter moved since the last one.
+     Called from both the audio thread and the editor; whoever gets there first does the
+     work and the other one just returns false without waiting.
+     */
+    bool publishSettingsIfChanged();
+    ChainSnapshot getChainSnapshot() const { return chainSnapshots.read(); }
+    
+    /*
+     applies every value in 'preset' in one step: the audio thread switches to all of them at
+     the start of its next block, and the host is told about the changes afterwards, in one batch
+     on the message thread. While the host isn't calling processBlock the timer applies them instead.
+     Call from the message thread only. Returns false if the queue is full.
+     */
+    bool applyPreset(const ParameterPreset& preset);
+    
+    // the same, but also recorded as one undoable step, labelled with 'description' (e.g. the chat prompt)
+    bool applyPreset(const ParameterPreset& preset, const juce::String& description);
+    
+    // between these two, every recorded preset joins a single step, e.g. a streamed AI reply
+    void beginHistoryStep(const juce::String& description);
+    void endHistoryStep();
+    
+    /*
+     undo/redo over AI turns, slot recalls and the user's own gestures (everything between the
+     first gesture starting and the last one ending is one step). Message thread only.
+     */
+    bool undo();
+    bool redo();
+    bool canUndo() const { return history.canUndo(); }
+    bool canRedo() const { return history.canRedo(); }
+    juce::String getUndoDescription() const { return history.getUndoDescription(); }
+    juce::String getRedoDescription() const { return history.getRedoDescription(); }
+    
+    // the chat, saved with the plugin state so it outlives the editor and the session
+    void setChatTranscript(const juce::String& transcript);
+    juce::String getChatTranscript() const;
+    
+    /*
+     A/B/C/D snapshot slots. Storing a slot also designs its ChainSnapshot, so recalling one
+     costs the audio thread nothing more than picking that snapshot up. Message thread only.
+     */
+    static constexpr int numSnapshotSlots = 4;
+    
+    void storeSnapshotSlot(int slot);
+    bool recallSnapshotSlot(int slot);
+    bool isSnapshotSlotStored(int slot) const;
+    int getActiveSnapshotSlot() const { return activeSnapshotSlot; }
+
     static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
     
     using BlockType = juce::AudioBuffer<float>;
     SingleChannelSampleFifo<BlockType> leftChannelFifo { Channel::Left };
     SingleChannelSampleFifo<BlockType> rightChannelFifo { Channel::Right };
+    
+    // what 'preset' would run, with everything it doesn't set at its current value
+    ChainSettings getChainSettings(const ParameterPreset& preset);
+    
+    // suggestions rendered on a loop of the input, which the output can be switched to for an A/B
+    PreviewLoopCapture previewCapture;
+    CandidateAudition candidateAudition;
 private:
-    // Equalizer
-    MonoChain leftChain, rightChain;
+    // one chain per precision, the host decides which one runs
+    ProcessingChain<float> floatChain;
+    ProcessingChain<double> doubleChain;
+    
+    SnapshotBuffer<ChainSnapshot> chainSnapshots;
+    std::atomic<bool> settingsChanged { true };
+    juce::SpinLock publishLock;
+    juce::uint32 publishedGeneration = 0;
+    juce::uint32 morphGeneration = 0;
+    
+    // samples of silent input seen since the last non-silent block
+    juce::int64 silentInputSamples = 0;
+    
+    template<typename SampleType>
+    void processChain(juce::AudioBuffer<SampleType>& buffer, ProcessingChain<SampleType>& chain);
+    
+    void publishSettings();
     
-    // Compressor
-    juce::dsp::Compressor<float> compressor;
+    // the parameters ChainSettings is built from, resolved by ID once in the constructor
+    std::array<std::atomic<float>*, numChainParameters> chainParameterValues {};
+    std::array<int, numChainParameters> chainParameterIndices {};
     
-    // Distortion
-    juce::dsp::WaveShaper<float, std::function<float(float)>> distortion;
+    ChainSettings getLiveChainSettings() const;
     
-    // Delay
-    juce::dsp::DelayLine<float> delayLine { 44100 }; // 1 second max at 44.1kHz
+    // presets: message thread -> audio thread -> message thread
+    juce::HashMap<juce::String, int> parameterIndices;
+    Fifo<ParameterPreset> presetCommands, presetNotifications;
+    ParameterPreset pendingPreset, inFlightPreset;
+    bool hasPendingPreset = false;
+    
+    // presets the audio thread is already running but the parameters don't show yet
+    std::atomic<int> presetsInFlight { 0 };
+    
+    // when the audio thread last started a block, so the timer can tell it has stopped calling
+    std::atomic<juce::uint32> lastBlockTime { 0 };
+    static constexpr juce::uint32 minimumIdleMs = 50;
+    
+    void pullPresetCommands();
+    void applyPendingPresets();
+    void timerCallback() override;
+    
+    void notifyHost(const ParameterPreset& preset);
+    bool isAudioThreadIdle() const;
+    void applyPendingPresetsHere();
+    
+    // the last snapshot the kernel builder was woken for
+    juce::uint32 kernelCheckedGeneration = 0;
+    
+    LinearPhaseKernelBuilder kernelBuilder
+    {
+        [this] { return getChainSnapshot(); },
+        [this](const ChainSnapshot& snapshot, const juce::AudioBuffer<float>& kernel) { applyLinearPhaseKernel(snapshot, kernel); }
+    };
+    
+    void applyLinearPhaseKernel(const ChainSnapshot& snapshot, const juce::AudioBuffer<float>& kernel);
+    
+    // snapshot slots: the presets belong to the message thread, the designed snapshots are shared
+    struct SnapshotSlot
+    {
+        ParameterPreset preset;
+        bool stored = false;
+    };
+    
+    juce::CriticalSection slotLock;
+    std::array<SnapshotSlot, numSnapshotSlots> snapshotSlots;
+    std::array<SnapshotBuffer<ChainSnapshot>, numSnapshotSlots> slotSnapshots;
+    int activeSnapshotSlot = 0;
+    
+    void designSnapshotSlot(int slot);
+    
+    // undo history, all on the message thread
+    ParameterHistory history;
+    ParameterHistory::Entry openStep;
+    bool stepIsOpen = false;
+    
+    // everything queued since the audio thread last caught up, so diffs start from where the queue will leave things
+    ParameterPreset requestedPreset;
+    
+    // values from before the current gesture group started, and how many gestures are still open
+    ParameterPreset gestureStartValues;
+    int openGestures = 0;
+    
+    // set while the timer is passing presets on to the host, whose gestures aren't the user's
+    bool notifyingHost = false;
+    
+    float getPlainValue(int parameterIndex) const;
+    void applyHistoryEntry(const ParameterHistory::Entry& entry, bool forwards);
+    void updateSnapshotSlotsForSampleRate();
+    
+    /*
+     the binary state: a header, then tagged chunks that readers skip if they don't know them.
+     Values are stored in parameter index order, plus each parameter's ID hash so a session
+     saved with a different parameter layout can still be mapped back by ID.
+     */
+    static constexpr int stateMagic = 0x74734747; // "GGst"
+    static constexpr int stateVersion = 1;
+    
+    enum StateChunk
+    {
+        ParameterValuesChunk = 1,
+        ParameterIDsChunk,
+        SnapshotSlotsChunk,
+        ChatTranscriptChunk     // GZIP compressed UTF-8
+    };
     
-    // Reverb
-    juce::dsp::Reverb reverb;
+    // hash of every parameter ID in index order, so a matching session is read without any lookups
+    juce::uint32 parameterLayoutHash = 0;
+    juce::HashMap<juce::uint32, int> parameterIndicesByHash;
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
-    void updateSettings();
-    void updateCompressorSettings();
-    void updateDistortionSettings();
-    void updateDelaySettings();
-    void updateReverbSettings();
+    void writeBinaryState(juce::OutputStream& stream);
+    bool readBinaryState(const void* data, int sizeInBytes);
     
+    juce::CriticalSection transcriptLock;
+    juce::String chatTranscript;
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimpleEQAudioProcessor)
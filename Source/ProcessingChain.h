@@ -0,0 +1,1289 @@
+/*
+  ==============================================================================
+
+    ProcessingChain.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include "ChainSnapshot.h"
+#include "MultibandCompressor.h"
+#include "SidechainCompressor.h"
+
+template<typename SampleType>
+using FilterType = juce::dsp::IIR::Filter<SampleType>;
+
+template<typename SampleType>
+using CutFilterType = juce::dsp::ProcessorChain<FilterType<SampleType>, FilterType<SampleType>, FilterType<SampleType>, FilterType<SampleType>>;
+
+template<typename SampleType>
+using MonoChainType = juce::dsp::ProcessorChain<CutFilterType<SampleType>, FilterType<SampleType>, CutFilterType<SampleType>>;
+
+using Filter = FilterType<float>;
+
+using CutFilter = CutFilterType<float>;
+
+using MonoChain = MonoChainType<float>;
+
+// the widest bus we accept, enough for 7.1.6 / 9.1.6 style immersive layouts
+constexpr int maxChannels = 16;
+
+enum ChainPositions
+{
+    LowCut,
+    Peak,
+    HighCut
+};
+
+enum ChainStages
+{
+    EQStage         = 1 << 0,
+    CompressorStage = 1 << 1,
+    DistortionStage = 1 << 2,
+    DelayStage      = 1 << 3,
+    ReverbStage     = 1 << 4,
+
+    NumStageCombinations = 1 << 5
+};
+
+int getActiveStages(const ChainSettings& chainSettings);
+
+constexpr int numChainStages = 5;
+constexpr int numChainOrders = 120; // 5!
+
+// the stages in the order they run in
+using ChainOrder = std::array<int, numChainStages>;
+
+/*
+ the 'index'th permutation of the stages, in lexicographic order starting from the
+ default EQ -> Compressor -> Distortion -> Delay -> Reverb, which is index 0.
+ */
+inline ChainOrder getChainOrder(int index)
+{
+    std::array<int, numChainStages> remaining { ChainStages::EQStage, ChainStages::CompressorStage, ChainStages::DistortionStage,
+                                                ChainStages::DelayStage, ChainStages::ReverbStage };
+    ChainOrder order {};
+
+    index = juce::jlimit(0, numChainOrders - 1, index);
+    int available = numChainStages;
+    int permutationsPerPick = numChainOrders / numChainStages;
+
+    for( auto& slot : order )
+    {
+        const auto pick = index / permutationsPerPick;
+        index %= permutationsPerPick;
+
+        slot = remaining[(size_t)pick];
+        for( int i = pick; i < available - 1; ++i )
+            remaining[(size_t)i] = remaining[(size_t)i + 1];
+
+        if( --available > 0 )
+            permutationsPerPick /= available;
+    }
+
+    return order;
+}
+
+inline juce::String getStageName(int stage)
+{
+    switch( stage )
+    {
+        case ChainStages::EQStage: return "EQ";
+        case ChainStages::CompressorStage: return "Comp";
+        case ChainStages::DistortionStage: return "Distortion";
+        case ChainStages::DelayStage: return "Delay";
+        case ChainStages::ReverbStage: return "Reverb";
+        default: jassertfalse; return {};
+    }
+}
+
+inline juce::String getChainOrderName(int index)
+{
+    juce::StringArray names;
+    for( auto stage : getChainOrder(index) )
+        names.add(getStageName(stage));
+
+    return names.joinIntoString(" > ");
+}
+
+/*
+ gives every filter in the chain its own second order coefficient set, so that later
+ updates can overwrite the raw values in place instead of allocating new ones.
+ */
+template<typename SampleType>
+void makeSecondOrder(MonoChainType<SampleType>& chain)
+{
+    using NumericType = typename FilterType<SampleType>::NumericType;
+    
+    auto makeFilterSecondOrder = [](FilterType<SampleType>& filter)
+    {
+        filter.coefficients = new juce::dsp::IIR::Coefficients<NumericType>(1, 0, 0, 1, 0, 0);
+    };
+
+    auto makeCutFilterSecondOrder = [&](CutFilterType<SampleType>& cutFilter)
+    {
+        makeFilterSecondOrder(cutFilter.template get<0>());
+        makeFilterSecondOrder(cutFilter.template get<1>());
+        makeFilterSecondOrder(cutFilter.template get<2>());
+        makeFilterSecondOrder(cutFilter.template get<3>());
+    };
+
+    makeCutFilterSecondOrder(chain.template get<ChainPositions::LowCut>());
+    makeFilterSecondOrder(chain.template get<ChainPositions::Peak>());
+    makeCutFilterSecondOrder(chain.template get<ChainPositions::HighCut>());
+}
+
+template<typename FilterType>
+void updateCoefficients(FilterType& filter, const BiquadCoefficients& replacements)
+{
+    jassert(filter.coefficients->getFilterOrder() == 2);
+    std::copy(replacements.values.begin(), replacements.values.end(), filter.coefficients->getRawCoefficients());
+}
+
+template<int Index, typename ChainType>
+void update(ChainType& chain, const CutCoefficients& coefficients)
+{
+    updateCoefficients(chain.template get<Index>(), coefficients.stages[Index]);
+    chain.template setBypassed<Index>(false);
+}
+
+template<typename ChainType>
+void updateCutFilter(ChainType& chain,
+                     const CutCoefficients& coefficients,
+                     const Slope& slope)
+{
+    chain.template setBypassed<0>(true);
+    chain.template setBypassed<1>(true);
+    chain.template setBypassed<2>(true);
+    chain.template setBypassed<3>(true);
+
+    switch( slope )
+    {
+        case Slope_48:
+        {
+            update<3>(chain, coefficients);
+        }
+        case Slope_36:
+        {
+            update<2>(chain, coefficients);
+        }
+        case Slope_24:
+        {
+            update<1>(chain, coefficients);
+        }
+        case Slope_12:
+        {
+            update<0>(chain, coefficients);
+        }
+    }
+}
+
+template<typename ChainType>
+void updateEQ(ChainType& chain, const ChainSnapshot& snapshot)
+{
+    const auto& chainSettings = snapshot.settings;
+    
+    chain.template setBypassed<ChainPositions::LowCut>(chainSettings.lowCutBypassed);
+    updateCutFilter(chain.template get<ChainPositions::LowCut>(), snapshot.lowCut, chainSettings.lowCutSlope);
+    
+    chain.template setBypassed<ChainPositions::Peak>(chainSettings.peakBypassed);
+    updateCoefficients(chain.template get<ChainPositions::Peak>(), snapshot.peak);
+    
+    chain.template setBypassed<ChainPositions::HighCut>(chainSettings.highCutBypassed);
+    updateCutFilter(chain.template get<ChainPositions::HighCut>(), snapshot.highCut, chainSettings.highCutSlope);
+}
+
+/**
+ EQ -> Compressor -> Distortion -> Delay -> Reverb, for either float or double buffers.
+ The processor owns one per precision and feeds it ChainSnapshots; everything in here
+ runs on the audio thread and never allocates after prepare().
+ 
+ Continuous parameters don't jump when a new snapshot arrives. They ramp over
+ smoothingTimeSeconds, and while anything is ramping the block is split into sub-blocks
+ of a fixed controlInterval samples. The filters are redesigned and the stage setters
+ called once per sub-block.
+
+ The stages run in the order given by the snapshot's chainOrder. The default order goes
+ through the compile-time specialised processStages(); any other order walks a table of
+ std::variant stages.
+
+ Any channel count up to maxChannels works. The EQ keeps its filter state interleaved by
+ channel, so every IIR step processes a whole SIMD register's worth of channels at once.
+ */
+template<typename SampleType>
+struct ProcessingChain
+{
+    using Block = juce::dsp::AudioBlock<SampleType>;
+    using SIMDSample = juce::dsp::SIMDRegister<SampleType>;
+
+    static constexpr size_t channelsPerRegister = SIMDSample::SIMDNumElements;
+    static constexpr size_t maxChannelGroups = (maxChannels + channelsPerRegister - 1) / channelsPerRegister;
+    static constexpr size_t maxChannelPairs = (maxChannels + 1) / 2;
+
+    static constexpr double smoothingTimeSeconds = 0.05;
+    static constexpr int controlInterval = 32;     // samples between parameter updates while they ramp
+
+    ProcessingChain()
+    {
+        for( auto& eqChain : eqChains )
+            makeSecondOrder(eqChain);
+
+        for( size_t pair = 0; pair < maxChannelPairs; ++pair )
+            linearPhaseConvolutions.add(new juce::dsp::Convolution(juce::dsp::Convolution::Latency { 0 }, *convolutionQueue));
+
+        distortion.functionToUse = [this](SampleType x)
+        {
+            return std::tanh(distortionDrive * x);
+        };
+    }
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        jassert(spec.numChannels <= (juce::uint32)maxChannels);
+        
+        sampleRate = spec.sampleRate;
+        numChannels = juce::jmin((size_t)spec.numChannels, (size_t)maxChannels);
+        numChannelGroups = (numChannels + channelsPerRegister - 1) / channelsPerRegister;
+
+        auto groupSpec = spec;
+        groupSpec.numChannels = 1;
+
+        for( size_t group = 0; group < numChannelGroups; ++group )
+            eqChains[group].prepare(groupSpec);
+
+        interleaved = juce::dsp::AudioBlock<SIMDSample>(interleavedData, numChannelGroups, spec.maximumBlockSize);
+
+        compressor.prepare(spec);
+        multibandCompressor.prepare(spec);
+        sidechainCompressor.prepare(spec);
+        delayLine.prepare(spec);
+
+        // juce's reverb and convolution are mono or stereo only, so surround buses get one per channel pair
+        for( size_t pair = 0; pair < getNumChannelPairs(); ++pair )
+        {
+            auto pairSpec = spec;
+            pairSpec.numChannels = (juce::uint32)juce::jmin((size_t)2, numChannels - pair * 2);
+            reverbs[pair].prepare(pairSpec);
+            linearPhaseConvolutions[(int)pair]->prepare(pairSpec);
+        }
+
+        crossfadeBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+        eqModeSwitchBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+        if constexpr( ! std::is_same_v<SampleType, float> )
+            floatBuffer.setSize((int)spec.numChannels, (int)spec.maximumBlockSize);
+
+        // the next snapshot has to be applied in full, and its stages switched in without a fade
+        appliedGeneration = 0;
+        activeStages = -1;
+        stageTransition = {};
+        orderFade = {};
+        eqModeSwitch = {};
+
+        forEachSmoother([&](auto& smoother) { smoother.reset(sampleRate, smoothingTimeSeconds); });
+    }
+
+    void applySnapshot(const ChainSnapshot& snapshot)
+    {
+        const auto& chainSettings = snapshot.settings;
+
+        // the first snapshot after prepare() starts from silence, there is nothing to ramp from
+        const bool jump = appliedGeneration == 0;
+
+        const bool eqModeChanged = ! jump && chainSettings.linearPhase != linearPhase;
+        linearPhase = chainSettings.linearPhase;
+
+        if( eqModeChanged )
+            startEQModeSwitch(linearPhase ? getLinearPhaseLatency(chainSettings.linearPhaseKernelSize) : 0);
+
+        // a new morph starts from whatever the smoothers are at right now
+        if( jump )
+        {
+            morph = {};
+            morph.id = snapshot.morphId;
+        }
+        else if( snapshot.morphId != morph.id )
+        {
+            morph.source = getCurrentSettings();
+            morph.id = snapshot.morphId;
+            morph.active = true;
+            morph.progress = 0.0;
+        }
+
+        targetSnapshot = snapshot;
+
+        pendingOrder = juce::jlimit(0, numChainOrders - 1, chainSettings.chainOrder);
+        if( jump )
+        {
+            stageTables[(size_t)activeTable] = makeStageTable(getChainOrder(pendingOrder));
+            activeOrder = pendingOrder;
+        }
+
+        compMultiband = chainSettings.compMultiband;
+        compSidechain = chainSettings.compSidechain;
+        multibandCompressor.setNumBands(chainSettings.compBands);
+
+        applySettings(getMorphedSettings(), jump);
+
+        // slopes and bypasses switch straight away, the coefficients follow the smoothers
+        if( isEQSmoothing() || morph.active )
+            applySmoothedEQ();
+        else
+            for( auto& eqChain : eqChains )
+                updateEQ(eqChain, snapshot);
+
+        applySmoothedDynamics();
+
+        appliedGeneration = snapshot.generation;
+    }
+
+    juce::uint32 getAppliedGeneration() const { return appliedGeneration; }
+
+    /*
+     hands a new linear-phase kernel to the convolution engines. Safe to call from any
+     thread: the engines load it in the background and crossfade to it once it's ready.
+     */
+    void loadLinearPhaseKernel(const juce::AudioBuffer<float>& kernel, double kernelSampleRate)
+    {
+        for( auto* convolution : linearPhaseConvolutions )
+        {
+            convolution->loadImpulseResponse(juce::AudioBuffer<float>(kernel),
+                                             kernelSampleRate,
+                                             juce::dsp::Convolution::Stereo::no,
+                                             juce::dsp::Convolution::Trim::no,
+                                             juce::dsp::Convolution::Normalise::no);
+        }
+    }
+
+    /** the delay the linear-phase EQ adds with a kernel of 'kernelSize' taps, engine included */
+    int getLinearPhaseLatency(int kernelSize) const
+    {
+        return kernelSize / 2 + linearPhaseConvolutions.getFirst()->getLatency();
+    }
+
+    /*
+     'sidechain' is the key for the compressor's detector, straight from the host's sidechain
+     bus. It has no channels when that bus is disabled, and is only used for this call.
+     */
+    void process(Block& block, int stages, const juce::dsp::AudioBlock<const SampleType>& sidechain = {})
+    {
+        sidechainBlock = sidechain;
+        processBlockStart = block.getChannelPointer(0);
+
+        if( ! isSmoothing() && ! morph.isRunning() )
+        {
+            processSubBlock(block, stages);
+            return;
+        }
+
+        const auto interval = (size_t)controlInterval;
+
+        for( size_t offset = 0; offset < block.getNumSamples(); offset += interval )
+        {
+            auto subBlock = block.getSubBlock(offset, juce::jmin(interval, block.getNumSamples() - offset));
+            advanceMorph((int)subBlock.getNumSamples());
+            advanceSmoothers((int)subBlock.getNumSamples());
+            processSubBlock(subBlock, stages);
+        }
+    }
+
+    /*
+     one instantiation per combination of active stages: the bypass checks are resolved at
+     compile time, so the steady state path through the chain has no per-stage branches.
+     */
+    template<int Stages>
+    void processStages(Block& block)
+    {
+        if constexpr( (Stages & ChainStages::EQStage) != 0 )
+            processEQ(block);
+        if constexpr( (Stages & ChainStages::CompressorStage) != 0 )
+            processCompressor(block);
+        if constexpr( (Stages & ChainStages::DistortionStage) != 0 )
+            processDistortion(block);
+        if constexpr( (Stages & ChainStages::DelayStage) != 0 )
+            processDelay(block);
+        if constexpr( (Stages & ChainStages::ReverbStage) != 0 )
+            processReverb(block);
+    }
+private:
+    void processSubBlock(Block& block, int stages)
+    {
+        if( orderFade.phase == OrderFade::Idle && pendingOrder != activeOrder )
+            orderFade = { OrderFade::FadingOut, 0, juce::jmax(1, juce::roundToInt(sampleRate * 0.005)) }; // 5ms each way
+
+        // the new order has to take over exactly where the fade out ends
+        if( orderFade.phase == OrderFade::FadingOut )
+        {
+            const auto remaining = (size_t)(orderFade.length - orderFade.samplesDone);
+
+            if( block.getNumSamples() > remaining )
+            {
+                auto head = block.getSubBlock(0, remaining);
+                auto tail = block.getSubBlock(remaining);
+                processSubBlock(head, stages);
+                processSubBlock(tail, stages);
+                return;
+            }
+        }
+
+        if( activeStages < 0 )
+            activeStages = stages;
+
+        if( stages != activeStages && ! stageTransition.isActive() )
+        {
+            stageTransition.fromStages = activeStages;
+            stageTransition.toStages = stages;
+            stageTransition.samplesDone = 0;
+            stageTransition.length = juce::jmax(1, juce::roundToInt(sampleRate * 0.005)); // 5ms
+        }
+
+        if( stageTransition.isActive() )
+            processStageTransition(block);
+        else
+            processActiveStages(block);
+
+        if( orderFade.phase != OrderFade::Idle )
+            applyOrderFade(block);
+    }
+
+    void processActiveStages(Block& block)
+    {
+        if( activeOrder == 0 )
+        {
+            (this->*getStageProcessor(activeStages))(block);
+            return;
+        }
+
+        for( const auto& stage : stageTables[(size_t)activeTable] )
+            if( (activeStages & getStage(stage)) != 0 )
+                processStage(stage, block);
+    }
+
+    /*
+     both orders share the same stage state, so they can't run side by side: the old order
+     fades out, the stages are cleared while the output is silent, and the new one fades in.
+     */
+    void applyOrderFade(Block& block)
+    {
+        const auto numSamples = (int)block.getNumSamples();
+        const bool fadingOut = orderFade.phase == OrderFade::FadingOut;
+
+        for( size_t ch = 0; ch < block.getNumChannels(); ++ch )
+        {
+            auto* data = block.getChannelPointer(ch);
+
+            for( int i = 0; i < numSamples; ++i )
+            {
+                auto progress = juce::jmin(SampleType(1), SampleType(orderFade.samplesDone + i) / SampleType(orderFade.length));
+                data[i] *= fadingOut ? SampleType(1) - progress : progress;
+            }
+        }
+
+        orderFade.samplesDone += numSamples;
+
+        if( orderFade.samplesDone < orderFade.length )
+            return;
+
+        if( fadingOut )
+        {
+            const auto nextTable = 1 - activeTable;
+            stageTables[(size_t)nextTable] = makeStageTable(getChainOrder(pendingOrder));
+            activeTable = nextTable;
+            activeOrder = pendingOrder;
+
+            for( int stage = ChainStages::EQStage; stage < ChainStages::NumStageCombinations; stage <<= 1 )
+                resetStage(stage);
+
+            orderFade = { OrderFade::FadingIn, 0, orderFade.length };
+        }
+        else
+        {
+            orderFade = {};
+        }
+    }
+
+    size_t numChannels = 2, numChannelGroups = 1;
+    
+    // Equalizer, one chain per group of channelsPerRegister channels
+    std::array<MonoChainType<SIMDSample>, maxChannelGroups> eqChains;
+    juce::HeapBlock<char> interleavedData;
+    juce::dsp::AudioBlock<SIMDSample> interleaved;
+
+    // Compressor
+    juce::dsp::Compressor<SampleType> compressor;
+    MultibandCompressor<SampleType> multibandCompressor;
+    bool compMultiband = false;
+
+    SidechainCompressor<SampleType> sidechainCompressor;
+    juce::dsp::AudioBlock<const SampleType> sidechainBlock;
+    const SampleType* processBlockStart = nullptr;
+    bool compSidechain = false;
+
+    // Distortion
+    juce::dsp::WaveShaper<SampleType, std::function<SampleType(SampleType)>> distortion;
+    SampleType distortionDrive = 1;
+
+    // Delay
+    juce::dsp::DelayLine<SampleType> delayLine { 44100 }; // 1 second max at 44.1kHz
+    SampleType delayFeedback = 0, delayMix = 0;
+
+    // Linear-phase EQ, with the kernels built on another thread. The engines load them on the
+    // queue's thread, one for every chain in the process, previews and plugin instances alike
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue> convolutionQueue;
+    juce::OwnedArray<juce::dsp::Convolution> linearPhaseConvolutions;
+    bool linearPhase = false;
+
+    // Reverb
+    std::array<juce::dsp::Reverb, maxChannelPairs> reverbs;
+
+    // the reverb and the convolution only come in float
+    juce::AudioBuffer<float> floatBuffer;
+    
+    size_t getNumChannelPairs() const { return (numChannels + 1) / 2; }
+
+    double sampleRate = 44100.0;
+    juce::uint32 appliedGeneration = 0;
+
+    // Smoothing: frequencies and Q ramp in ratio, everything else linearly
+    using MultiplicativeSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+    using LinearSmoother = juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear>;
+
+    MultiplicativeSmoother peakFreq, peakQuality, lowCutFreq, highCutFreq;
+    LinearSmoother peakGain;
+    LinearSmoother compThreshold, compRatio, compAttack, compRelease;
+    MultiplicativeSmoother crossoverLow, crossoverMid, crossoverHigh;
+    std::array<LinearSmoother, MultibandCompressor<SampleType>::maxBands> bandThresholds;
+    LinearSmoother distortionAmount;
+    LinearSmoother delayTimeMs, delayFeedbackAmount, delayMixAmount;
+
+    ChainSnapshot targetSnapshot;
+
+    template<typename Function>
+    void forEachSmoother(Function&& f)
+    {
+        f(peakFreq); f(peakQuality); f(lowCutFreq); f(highCutFreq); f(peakGain);
+        f(compThreshold); f(compRatio); f(compAttack); f(compRelease);
+        f(crossoverLow); f(crossoverMid); f(crossoverHigh);
+        for( auto& bandThreshold : bandThresholds ) f(bandThreshold);
+        f(distortionAmount);
+        f(delayTimeMs); f(delayFeedbackAmount); f(delayMixAmount);
+    }
+
+    /*
+     Morphing: after a preset arrives with a new morph id, the chain glides from where it was
+     to the preset over morphTimeSeconds. The morph position parameter then sets how far
+     towards the preset it goes, so automating it blends between the two.
+     */
+    struct MorphState
+    {
+        juce::uint32 id = 0;
+        bool active = false;
+        double progress = 1.0;
+        ChainSettings source;
+
+        bool isRunning() const { return active && progress < 1.0; }
+    };
+
+    MorphState morph;
+    ChainSettings appliedSettings;
+
+    ChainSettings getMorphedSettings() const
+    {
+        const auto& target = targetSnapshot.settings;
+
+        if( ! morph.active )
+            return target;
+
+        const auto position = (float)morph.progress * juce::jlimit(0.f, 1.f, target.morphPosition);
+        return morphChainSettings(morph.source, target, position);
+    }
+
+    // what the chain sounds like at this moment, smoothers included
+    ChainSettings getCurrentSettings() const
+    {
+        auto settings = appliedSettings;
+
+        settings.peakFreq = peakFreq.getCurrentValue();
+        settings.peakGainInDecibels = peakGain.getCurrentValue();
+        settings.peakQuality = peakQuality.getCurrentValue();
+        settings.lowCutFreq = lowCutFreq.getCurrentValue();
+        settings.highCutFreq = highCutFreq.getCurrentValue();
+        settings.compThreshold = compThreshold.getCurrentValue();
+        settings.compRatio = compRatio.getCurrentValue();
+        settings.compAttack = compAttack.getCurrentValue();
+        settings.compRelease = compRelease.getCurrentValue();
+        settings.compCrossoverLow = crossoverLow.getCurrentValue();
+        settings.compCrossoverMid = crossoverMid.getCurrentValue();
+        settings.compCrossoverHigh = crossoverHigh.getCurrentValue();
+
+        for( size_t band = 0; band < bandThresholds.size(); ++band )
+            settings.compBandSettings[band].threshold = bandThresholds[band].getCurrentValue();
+
+        settings.distortionAmount = distortionAmount.getCurrentValue();
+        settings.delayTimeMs = delayTimeMs.getCurrentValue();
+        settings.delayFeedback = delayFeedbackAmount.getCurrentValue();
+        settings.delayMix = delayMixAmount.getCurrentValue();
+
+        return settings;
+    }
+
+    void advanceMorph(int numSamples)
+    {
+        if( ! morph.isRunning() )
+            return;
+
+        const auto morphSamples = (double)targetSnapshot.settings.morphTimeSeconds * sampleRate;
+        morph.progress = morphSamples > 0.0 ? juce::jmin(1.0, morph.progress + numSamples / morphSamples) : 1.0;
+
+        applySettings(getMorphedSettings(), false);
+
+        // all the way there: the chain follows the parameters directly again
+        if( morph.progress >= 1.0 && targetSnapshot.settings.morphPosition >= 1.f )
+            morph.active = false;
+    }
+
+    /*
+     points the smoothers at 'settings' and sets everything that isn't smoothed: the band
+     ratios and times, the sidechain filter and the reverb, which ramps internally.
+     */
+    void applySettings(const ChainSettings& settings, bool jump)
+    {
+        appliedSettings = settings;
+
+        setSmoothingTarget(peakFreq, settings.peakFreq, jump);
+        setSmoothingTarget(peakGain, settings.peakGainInDecibels, jump);
+        setSmoothingTarget(peakQuality, settings.peakQuality, jump);
+        setSmoothingTarget(lowCutFreq, settings.lowCutFreq, jump);
+        setSmoothingTarget(highCutFreq, settings.highCutFreq, jump);
+        setSmoothingTarget(compThreshold, settings.compThreshold, jump);
+        setSmoothingTarget(compRatio, settings.compRatio, jump);
+        setSmoothingTarget(compAttack, settings.compAttack, jump);
+        setSmoothingTarget(compRelease, settings.compRelease, jump);
+        setSmoothingTarget(crossoverLow, settings.compCrossoverLow, jump);
+        setSmoothingTarget(crossoverMid, settings.compCrossoverMid, jump);
+        setSmoothingTarget(crossoverHigh, settings.compCrossoverHigh, jump);
+
+        for( int band = 0; band < MultibandCompressor<SampleType>::maxBands; ++band )
+            setSmoothingTarget(bandThresholds[(size_t)band], settings.compBandSettings[(size_t)band].threshold, jump);
+
+        setSmoothingTarget(distortionAmount, settings.distortionAmount, jump);
+        setSmoothingTarget(delayTimeMs, settings.delayTimeMs, jump);
+        setSmoothingTarget(delayFeedbackAmount, settings.delayFeedback, jump);
+        setSmoothingTarget(delayMixAmount, settings.delayMix, jump);
+
+        for( int band = 0; band < MultibandCompressor<SampleType>::maxBands; ++band )
+        {
+            const auto& bandSettings = settings.compBandSettings[(size_t)band];
+            auto& bandCompressor = multibandCompressor.getBand(band);
+
+            bandCompressor.setRatio(static_cast<SampleType>(bandSettings.ratio));
+            bandCompressor.setAttack(static_cast<SampleType>(bandSettings.attack));
+            bandCompressor.setRelease(static_cast<SampleType>(bandSettings.release));
+        }
+
+        sidechainCompressor.setKeyHighPassFrequency(static_cast<SampleType>(settings.compSidechainHighPass));
+
+        // juce::Reverb already ramps its gains and damping internally
+        juce::dsp::Reverb::Parameters params;
+        params.roomSize = settings.reverbSize;
+        params.wetLevel = settings.reverbMix;
+        params.dryLevel = 1.0f - params.wetLevel;
+        params.damping  = juce::jlimit(0.0f, 1.0f, settings.reverbDecay / 10.0f);
+
+        for( auto& reverb : reverbs )
+            reverb.setParameters(params);
+    }
+
+    template<typename Smoother>
+    static void setSmoothingTarget(Smoother& smoother, float target, bool jump)
+    {
+        if( jump )
+            smoother.setCurrentAndTargetValue(target);
+        else
+            smoother.setTargetValue(target);
+    }
+
+    bool isEQSmoothing() const
+    {
+        return peakFreq.isSmoothing() || peakGain.isSmoothing() || peakQuality.isSmoothing()
+            || lowCutFreq.isSmoothing() || highCutFreq.isSmoothing();
+    }
+
+    bool isDynamicsSmoothing() const
+    {
+        return compThreshold.isSmoothing() || compRatio.isSmoothing() || compAttack.isSmoothing()
+            || compRelease.isSmoothing() || distortionAmount.isSmoothing()
+            || crossoverLow.isSmoothing() || crossoverMid.isSmoothing() || crossoverHigh.isSmoothing()
+            || std::any_of(bandThresholds.begin(), bandThresholds.end(), [](const auto& s) { return s.isSmoothing(); })
+            || delayTimeMs.isSmoothing() || delayFeedbackAmount.isSmoothing() || delayMixAmount.isSmoothing();
+    }
+
+    bool isSmoothing() const { return isEQSmoothing() || isDynamicsSmoothing(); }
+
+    void advanceSmoothers(int numSamples)
+    {
+        const bool eqWasSmoothing = isEQSmoothing();
+        const bool dynamicsWereSmoothing = isDynamicsSmoothing();
+
+        forEachSmoother([numSamples](auto& smoother) { smoother.skip(numSamples); });
+
+        if( eqWasSmoothing )
+            applySmoothedEQ();
+
+        if( dynamicsWereSmoothing )
+            applySmoothedDynamics();
+    }
+
+    /*
+     redesigns the filters from the smoothed parameters rather than interpolating
+     coefficients, which can pass through unstable pole positions on the way.
+     */
+    void applySmoothedEQ()
+    {
+        ChainSnapshot smoothed;
+        smoothed.settings = targetSnapshot.settings;
+        smoothed.sampleRate = sampleRate;
+
+        smoothed.settings.peakFreq = peakFreq.getCurrentValue();
+        smoothed.settings.peakGainInDecibels = peakGain.getCurrentValue();
+        smoothed.settings.peakQuality = peakQuality.getCurrentValue();
+        smoothed.settings.lowCutFreq = lowCutFreq.getCurrentValue();
+        smoothed.settings.highCutFreq = highCutFreq.getCurrentValue();
+
+        smoothed.peak = makePeakFilter(smoothed.settings, sampleRate);
+        smoothed.lowCut = makeLowCutFilter(smoothed.settings, sampleRate);
+        smoothed.highCut = makeHighCutFilter(smoothed.settings, sampleRate);
+
+        for( size_t group = 0; group < numChannelGroups; ++group )
+            updateEQ(eqChains[group], smoothed);
+    }
+
+    void applySmoothedDynamics()
+    {
+        compressor.setThreshold(static_cast<SampleType>(compThreshold.getCurrentValue()));
+        compressor.setRatio(static_cast<SampleType>(compRatio.getCurrentValue()));
+        compressor.setAttack(static_cast<SampleType>(compAttack.getCurrentValue()));
+        compressor.setRelease(static_cast<SampleType>(compRelease.getCurrentValue()));
+
+        sidechainCompressor.setThreshold(static_cast<SampleType>(compThreshold.getCurrentValue()));
+        sidechainCompressor.setRatio(static_cast<SampleType>(compRatio.getCurrentValue()));
+        sidechainCompressor.setAttack(static_cast<SampleType>(compAttack.getCurrentValue()));
+        sidechainCompressor.setRelease(static_cast<SampleType>(compRelease.getCurrentValue()));
+
+        multibandCompressor.setCrossoverFrequencies(static_cast<SampleType>(crossoverLow.getCurrentValue()),
+                                                    static_cast<SampleType>(crossoverMid.getCurrentValue()),
+                                                    static_cast<SampleType>(crossoverHigh.getCurrentValue()));
+
+        for( int band = 0; band < MultibandCompressor<SampleType>::maxBands; ++band )
+            multibandCompressor.getBand(band).setThreshold(static_cast<SampleType>(bandThresholds[(size_t)band].getCurrentValue()));
+
+        distortionDrive = static_cast<SampleType>(distortionAmount.getCurrentValue());
+
+        delayFeedback = static_cast<SampleType>(delayFeedbackAmount.getCurrentValue());
+        delayMix = static_cast<SampleType>(delayMixAmount.getCurrentValue());
+        auto delayTimeSamples = sampleRate * delayTimeMs.getCurrentValue() / 1000.0;
+        delayLine.setDelay(static_cast<SampleType>(juce::jmin(delayTimeSamples, (double)delayLine.getMaximumDelayInSamples())));
+    }
+
+    struct StageTransition
+    {
+        int fromStages = 0, toStages = 0;
+        int samplesDone = 0, length = 0;
+
+        bool isActive() const { return samplesDone < length; }
+    };
+
+    int activeStages = -1;
+    StageTransition stageTransition;
+    juce::AudioBuffer<SampleType> crossfadeBuffer;
+
+    /*
+     switching between the IIR and the linear-phase EQ. Their outputs are the kernel's latency
+     apart, so crossfading them would comb, and the incoming EQ has to run that long after a
+     reset before its output means anything. The outgoing EQ fades out, the incoming one runs
+     unheard until it's valid, and then fades in.
+     */
+    struct EQModeSwitch
+    {
+        bool active = false;
+        bool fadingOut = false;     // the EQ being left is still the one heard
+        SampleType gain = 1;        // of whichever EQ is heard
+        int preRollLeft = 0;        // samples before the incoming EQ's output is valid
+        int fadeLength = 1;
+    };
+
+    EQModeSwitch eqModeSwitch;
+    juce::AudioBuffer<SampleType> eqModeSwitchBuffer;
+
+    // 'linearPhase' already says which EQ is incoming
+    void startEQModeSwitch(int incomingLatency)
+    {
+        // turned back while the EQ being left is still heard: it was never reset, so it just fades back in
+        if( eqModeSwitch.active && eqModeSwitch.fadingOut )
+        {
+            eqModeSwitch.fadingOut = false;
+            eqModeSwitch.preRollLeft = 0;
+            return;
+        }
+
+        // otherwise whatever is heard fades out from where it is, and the other EQ starts from scratch
+        if( ! eqModeSwitch.active )
+            eqModeSwitch.gain = 1;
+
+        eqModeSwitch.active = true;
+        eqModeSwitch.fadingOut = true;
+        eqModeSwitch.preRollLeft = incomingLatency;
+        eqModeSwitch.fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.01)); // 10ms each way
+
+        if( linearPhase )
+            resetLinearPhaseEQ();
+        else
+            resetIIREQ();
+    }
+
+    // Stage order: one variant per slot, so a table holds any permutation without allocating
+    template<int Stage>
+    struct StageTag { static constexpr int stage = Stage; };
+
+    using StageVariant = std::variant<StageTag<ChainStages::EQStage>,
+                                      StageTag<ChainStages::CompressorStage>,
+                                      StageTag<ChainStages::DistortionStage>,
+                                      StageTag<ChainStages::DelayStage>,
+                                      StageTag<ChainStages::ReverbStage>>;
+    using StageTable = std::array<StageVariant, numChainStages>;
+
+    static StageVariant makeStageVariant(int stage)
+    {
+        switch( stage )
+        {
+            case ChainStages::CompressorStage: return StageTag<ChainStages::CompressorStage>();
+            case ChainStages::DistortionStage: return StageTag<ChainStages::DistortionStage>();
+            case ChainStages::DelayStage: return StageTag<ChainStages::DelayStage>();
+            case ChainStages::ReverbStage: return StageTag<ChainStages::ReverbStage>();
+            default: return StageTag<ChainStages::EQStage>();
+        }
+    }
+
+    static StageTable makeStageTable(const ChainOrder& order)
+    {
+        StageTable table;
+        for( size_t slot = 0; slot < order.size(); ++slot )
+            table[slot] = makeStageVariant(order[slot]);
+
+        return table;
+    }
+
+    static int getStage(const StageVariant& stage)
+    {
+        return std::visit([](auto tag) { return decltype(tag)::stage; }, stage);
+    }
+
+    // the live table and the one the next order gets built in
+    std::array<StageTable, 2> stageTables { makeStageTable(getChainOrder(0)), makeStageTable(getChainOrder(0)) };
+    int activeTable = 0;
+    int activeOrder = 0, pendingOrder = 0;
+
+    struct OrderFade
+    {
+        enum Phase { Idle, FadingOut, FadingIn };
+
+        Phase phase = Idle;
+        int samplesDone = 0, length = 0;
+    };
+
+    OrderFade orderFade;
+
+    using StageProcessor = void (ProcessingChain::*)(Block&);
+
+    template<size_t... Stages>
+    static constexpr std::array<StageProcessor, sizeof...(Stages)> makeStageProcessorTable(std::index_sequence<Stages...>)
+    {
+        return { &ProcessingChain::processStages<int(Stages)>... };
+    }
+
+    static StageProcessor getStageProcessor(int stages)
+    {
+        static constexpr auto table = makeStageProcessorTable(std::make_index_sequence<ChainStages::NumStageCombinations>());
+
+        jassert(juce::isPositiveAndBelow(stages, (int)ChainStages::NumStageCombinations));
+        return table[(size_t)stages];
+    }
+
+    /**========================
+     *   1. Process EQ
+     *=========================*/
+    void processEQ(Block& block)
+    {
+        if( eqModeSwitch.active )
+            processEQModeSwitch(block);
+        else if( linearPhase )
+            processLinearPhaseEQ(block);
+        else
+            processIIREQ(block);
+    }
+
+    /*
+     runs the incoming EQ throughout, and the outgoing one only while it is still being faded
+     out, then applies the switch's gain to whichever of the two is heard.
+     */
+    void processEQModeSwitch(Block& block)
+    {
+        const auto maxChunk = (size_t)eqModeSwitchBuffer.getNumSamples();
+        const auto step = SampleType(1) / SampleType(eqModeSwitch.fadeLength);
+
+        for( size_t offset = 0; offset < block.getNumSamples(); offset += maxChunk )
+        {
+            auto chunk = block.getSubBlock(offset, juce::jmin(maxChunk, block.getNumSamples() - offset));
+            const auto numSamples = (int)chunk.getNumSamples();
+
+            if( ! eqModeSwitch.active )
+            {
+                if( linearPhase )
+                    processLinearPhaseEQ(chunk);
+                else
+                    processIIREQ(chunk);
+
+                continue;
+            }
+
+            auto outgoing = Block(eqModeSwitchBuffer).getSubsetChannelBlock(0, chunk.getNumChannels())
+                                                     .getSubBlock(0, chunk.getNumSamples());
+
+            if( eqModeSwitch.fadingOut )
+            {
+                outgoing.copyFrom(chunk);
+
+                if( linearPhase )
+                    processIIREQ(outgoing);
+                else
+                    processLinearPhaseEQ(outgoing);
+            }
+
+            if( linearPhase )
+                processLinearPhaseEQ(chunk);
+            else
+                processIIREQ(chunk);
+
+            for( int i = 0; i < numSamples; ++i )
+            {
+                const auto& heard = eqModeSwitch.fadingOut ? outgoing : chunk;
+
+                for( size_t ch = 0; ch < chunk.getNumChannels(); ++ch )
+                    chunk.setSample((int)ch, i, eqModeSwitch.gain * heard.getSample((int)ch, i));
+
+                if( eqModeSwitch.fadingOut )
+                {
+                    eqModeSwitch.gain = juce::jmax(SampleType(0), eqModeSwitch.gain - step);
+                    eqModeSwitch.fadingOut = eqModeSwitch.gain > SampleType(0);
+                }
+                else if( eqModeSwitch.preRollLeft == 0 )
+                {
+                    eqModeSwitch.gain = juce::jmin(SampleType(1), eqModeSwitch.gain + step);
+                    eqModeSwitch.active = eqModeSwitch.gain < SampleType(1);
+                }
+
+                eqModeSwitch.preRollLeft = juce::jmax(0, eqModeSwitch.preRollLeft - 1);
+            }
+        }
+    }
+
+    void resetIIREQ()
+    {
+        for( auto& eqChain : eqChains )
+            eqChain.reset();
+    }
+
+    void resetLinearPhaseEQ()
+    {
+        for( auto* convolution : linearPhaseConvolutions )
+            convolution->reset();
+    }
+
+    void processIIREQ(Block& block)
+    {
+        const auto maxChunk = interleaved.getNumSamples();
+        const auto blockChannels = juce::jmin(block.getNumChannels(), numChannels);
+
+        for( size_t offset = 0; offset < block.getNumSamples(); offset += maxChunk )
+        {
+            auto chunk = block.getSubBlock(offset, juce::jmin(maxChunk, block.getNumSamples() - offset));
+            const auto numSamples = chunk.getNumSamples();
+
+            for( size_t group = 0; group * channelsPerRegister < blockChannels; ++group )
+            {
+                const auto firstChannel = group * channelsPerRegister;
+                const auto groupChannels = juce::jmin(channelsPerRegister, blockChannels - firstChannel);
+                auto* lanes = reinterpret_cast<SampleType*>(interleaved.getChannelPointer(group));
+
+                // unused lanes carry silence so their filter state stays clean
+                for( size_t lane = 0; lane < channelsPerRegister; ++lane )
+                {
+                    const auto* source = lane < groupChannels ? chunk.getChannelPointer(firstChannel + lane) : nullptr;
+
+                    for( size_t i = 0; i < numSamples; ++i )
+                        lanes[i * channelsPerRegister + lane] = source != nullptr ? source[i] : SampleType(0);
+                }
+
+                auto groupBlock = interleaved.getSingleChannelBlock(group).getSubBlock(0, numSamples);
+                juce::dsp::ProcessContextReplacing<SIMDSample> context(groupBlock);
+                eqChains[group].process(context);
+
+                for( size_t lane = 0; lane < groupChannels; ++lane )
+                {
+                    auto* destination = chunk.getChannelPointer(firstChannel + lane);
+
+                    for( size_t i = 0; i < numSamples; ++i )
+                        destination[i] = lanes[i * channelsPerRegister + lane];
+                }
+            }
+        }
+    }
+
+    /**========================
+     *   2. Compressor
+     *=========================*/
+    void processCompressor(Block& block)
+    {
+        if( compMultiband )
+        {
+            multibandCompressor.process(block);
+            return;
+        }
+
+        if( compSidechain && sidechainBlock.getNumChannels() > 0 )
+        {
+            // the block is a slice of the one passed to process(), the key has to be the same slice
+            const auto offset = (size_t)(block.getChannelPointer(0) - processBlockStart);
+            jassert(offset + block.getNumSamples() <= sidechainBlock.getNumSamples());
+
+            sidechainCompressor.process(block, sidechainBlock.getSubBlock(offset, block.getNumSamples()));
+            return;
+        }
+
+        juce::dsp::ProcessContextReplacing<SampleType> context(block);
+        compressor.process(context);
+    }
+
+    /**========================
+     *   3. Distortion
+     *=========================*/
+    void processDistortion(Block& block)
+    {
+        auto numChannels = block.getNumChannels();
+        auto numSamples = block.getNumSamples();
+
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            for (size_t i = 0; i < numSamples; ++i)
+            {
+                auto sample = block.getSample((int)ch, (int)i);
+                block.setSample((int)ch, (int)i, distortion.functionToUse(sample));
+            }
+        }
+    }
+
+    /**========================
+     *   4. Delay
+     *=========================*/
+    void processDelay(Block& block)
+    {
+        auto feedback = delayFeedback;
+        auto mix = delayMix;
+
+        for (size_t channel = 0; channel < block.getNumChannels(); ++channel)
+        {
+            auto* channelData = block.getChannelPointer(channel);
+            for (size_t i = 0; i < block.getNumSamples(); ++i)
+            {
+                auto delayed = delayLine.popSample((int)channel);
+                auto input = channelData[i];
+                delayLine.pushSample((int)channel, input + delayed * feedback);
+                channelData[i] = input * (SampleType(1) - mix) + delayed * mix;
+            }
+        }
+    }
+
+    /**========================
+     *   5. Reverb
+     *=========================*/
+    void processReverb(Block& block)
+    {
+        processInFloat(block, [this](juce::dsp::AudioBlock<float>& floatBlock)
+        {
+            processInPairs(floatBlock, reverbs);
+        });
+    }
+
+    void processLinearPhaseEQ(Block& block)
+    {
+        processInFloat(block, [this](juce::dsp::AudioBlock<float>& floatBlock)
+        {
+            processInPairs(floatBlock, linearPhaseConvolutions);
+        });
+    }
+
+    /*
+     the reverb and the convolution only come in float, so the double chain runs them
+     on a float copy of the block.
+     */
+    template<typename Function>
+    void processInFloat(Block& block, Function&& process)
+    {
+        if constexpr( std::is_same_v<SampleType, float> )
+        {
+            process(block);
+        }
+        else
+        {
+            const auto maxChunk = (size_t)floatBuffer.getNumSamples();
+
+            for( size_t offset = 0; offset < block.getNumSamples(); offset += maxChunk )
+            {
+                auto chunk = block.getSubBlock(offset, juce::jmin(maxChunk, block.getNumSamples() - offset));
+                auto floatBlock = juce::dsp::AudioBlock<float>(floatBuffer).getSubsetChannelBlock(0, chunk.getNumChannels())
+                                                                           .getSubBlock(0, chunk.getNumSamples());
+
+                for( size_t ch = 0; ch < chunk.getNumChannels(); ++ch )
+                    for( size_t i = 0; i < chunk.getNumSamples(); ++i )
+                        floatBlock.getChannelPointer(ch)[i] = static_cast<float>(chunk.getChannelPointer(ch)[i]);
+
+                process(floatBlock);
+
+                for( size_t ch = 0; ch < chunk.getNumChannels(); ++ch )
+                    for( size_t i = 0; i < chunk.getNumSamples(); ++i )
+                        chunk.getChannelPointer(ch)[i] = static_cast<SampleType>(floatBlock.getChannelPointer(ch)[i]);
+            }
+        }
+    }
+
+    static juce::dsp::Reverb& getProcessor(std::array<juce::dsp::Reverb, maxChannelPairs>& reverbs, size_t pair) { return reverbs[pair]; }
+    static juce::dsp::Convolution& getProcessor(juce::OwnedArray<juce::dsp::Convolution>& convolutions, size_t pair) { return *convolutions[(int)pair]; }
+
+    // for the processors that only handle mono or stereo: one per channel pair
+    template<typename Processors>
+    void processInPairs(juce::dsp::AudioBlock<float>& block, Processors& processors)
+    {
+        for( size_t pair = 0; pair < getNumChannelPairs() && pair * 2 < block.getNumChannels(); ++pair )
+        {
+            auto pairBlock = block.getSubsetChannelBlock(pair * 2, juce::jmin((size_t)2, block.getNumChannels() - pair * 2));
+            juce::dsp::ProcessContextReplacing<float> context(pairBlock);
+            getProcessor(processors, pair).process(context);
+        }
+    }
+
+    void processStage(const StageVariant& stage, Block& block)
+    {
+        std::visit([this, &block](auto tag)
+        {
+            constexpr auto Stage = decltype(tag)::stage;
+
+            if constexpr( Stage == ChainStages::EQStage )
+                processEQ(block);
+            else if constexpr( Stage == ChainStages::CompressorStage )
+                processCompressor(block);
+            else if constexpr( Stage == ChainStages::DistortionStage )
+                processDistortion(block);
+            else if constexpr( Stage == ChainStages::DelayStage )
+                processDelay(block);
+            else
+                processReverb(block);
+        }, stage);
+    }
+
+    void resetStage(int stage)
+    {
+        switch( stage )
+        {
+            case ChainStages::EQStage: resetIIREQ(); resetLinearPhaseEQ(); break;
+            case ChainStages::CompressorStage: compressor.reset(); multibandCompressor.reset(); sidechainCompressor.reset(); break;
+            case ChainStages::DelayStage: delayLine.reset(); break;
+            case ChainStages::ReverbStage: for( auto& reverb : reverbs ) reverb.reset(); break;
+            default: break;
+        }
+    }
+
+    /*
+     runs every stage that is active on either side of the switch, and fades the stages that
+     are being switched in or out between their input and their output.
+     */
+    void processStageTransition(Block& block)
+    {
+        const auto fromStages = stageTransition.fromStages;
+        const auto toStages = stageTransition.toStages;
+        const auto maxChunk = (size_t)crossfadeBuffer.getNumSamples();
+
+        for( size_t offset = 0; offset < block.getNumSamples(); offset += maxChunk )
+        {
+            auto chunk = block.getSubBlock(offset, juce::jmin(maxChunk, block.getNumSamples() - offset));
+            const auto numSamples = (int)chunk.getNumSamples();
+
+            if( ! stageTransition.isActive() )
+            {
+                processActiveStages(chunk);
+                continue;
+            }
+
+            const auto rampStart = SampleType(stageTransition.samplesDone) / SampleType(stageTransition.length);
+            const auto rampEnd = juce::jmin(SampleType(1), SampleType(stageTransition.samplesDone + numSamples) / SampleType(stageTransition.length));
+
+            for( const auto& entry : stageTables[(size_t)activeTable] )
+            {
+                const auto stage = getStage(entry);
+                const bool wasActive = (fromStages & stage) != 0;
+                const bool willBeActive = (toStages & stage) != 0;
+
+                if( ! wasActive && ! willBeActive )
+                    continue;
+
+                if( wasActive && willBeActive )
+                {
+                    processStage(entry, chunk);
+                    continue;
+                }
+
+                if( willBeActive && stageTransition.samplesDone == 0 )
+                    resetStage(stage);
+
+                auto dry = Block(crossfadeBuffer).getSubsetChannelBlock(0, chunk.getNumChannels())
+                                                 .getSubBlock(0, chunk.getNumSamples());
+                dry.copyFrom(chunk);
+
+                processStage(entry, chunk);
+
+                const auto wetStart = willBeActive ? rampStart : SampleType(1) - rampStart;
+                const auto wetEnd = willBeActive ? rampEnd : SampleType(1) - rampEnd;
+
+                for( size_t ch = 0; ch < chunk.getNumChannels(); ++ch )
+                {
+                    auto* wetData = chunk.getChannelPointer(ch);
+                    auto* dryData = dry.getChannelPointer(ch);
+
+                    for( int i = 0; i < numSamples; ++i )
+                    {
+                        auto wet = juce::jmap(SampleType(i) / SampleType(numSamples), wetStart, wetEnd);
+                        wetData[i] = dryData[i] + wet * (wetData[i] - dryData[i]);
+                    }
+                }
+            }
+
+            stageTransition.samplesDone += numSamples;
+
+            if( ! stageTransition.isActive() )
+                activeStages = toStages;
+        }
+    }
+
+    // the distortion lambda holds on to 'this'
+    JUCE_DECLARE_NON_COPYABLE(ProcessingChain)
+    JUCE_DECLARE_NON_MOVEABLE(ProcessingChain)
+};
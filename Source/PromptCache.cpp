@@ -0,0 +1,336 @@
+/*
+  ==============================================================================
+
+    PromptCache.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "PromptCache.h"
+
+PromptPresetCache::PromptPresetCache()
+    : PromptPresetCache(getDefaultFile())
+{
+}
+
+PromptPresetCache::PromptPresetCache(const juce::File& cacheFile)
+    : file(cacheFile)
+{
+    const juce::InterProcessLock::ScopedLockType fl(fileLock);
+
+    // without the file every lookup just misses, which is only slower
+    if( ! fl.isLocked() || ! open() )
+        DBG("Prompt cache unavailable: " << file.getFullPathName());
+}
+
+juce::File PromptPresetCache::getDefaultFile()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+               .getChildFile("GenreGenie")
+               .getChildFile("PromptCache.bin");
+}
+
+bool PromptPresetCache::open()
+{
+    const auto size = (juce::int64)(sizeof(Header) + sizeof(Record) * capacity);
+
+    auto map = [this, size]
+    {
+        mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readWrite);
+        if( mappedFile->getData() == nullptr || (juce::int64)mappedFile->getSize() != size )
+            mappedFile.reset();
+
+        return mappedFile != nullptr;
+    };
+
+    if( file.getSize() == size && map() )
+    {
+        auto* header = getHeader();
+        if( header->magic == magic && header->version == version && header->capacity == (juce::uint32)capacity )
+            return true;
+
+        mappedFile.reset();
+    }
+
+    // missing, or from another version: start again with an empty one
+    if( file.getParentDirectory().createDirectory().failed() || ! file.deleteFile() )
+        return false;
+
+    {
+        juce::FileOutputStream stream(file);
+        if( ! stream.openedOk() )
+            return false;
+
+        Header header {};
+        header.magic = magic;
+        header.version = version;
+        header.capacity = capacity;
+
+        stream.write(&header, sizeof(header));
+        stream.writeRepeatedByte(0, sizeof(Record) * capacity);
+    }
+
+    return map();
+}
+
+PromptPresetCache::Header* PromptPresetCache::getHeader() const
+{
+    return static_cast<Header*>(mappedFile->getData());
+}
+
+PromptPresetCache::Record* PromptPresetCache::getRecord(int index) const
+{
+    return reinterpret_cast<Record*>(static_cast<char*>(mappedFile->getData()) + sizeof(Header)) + index;
+}
+
+std::optional<PromptPresetCache::Match> PromptPresetCache::find(const juce::String& prompt, juce::uint64 stateFingerprint)
+{
+    const juce::ScopedLock sl(lock);
+    if( mappedFile == nullptr )
+        return {};
+
+    const juce::InterProcessLock::ScopedLockType fl(fileLock);
+    if( ! fl.isLocked() )
+        return {};
+
+    auto normalised = normalisePrompt(prompt);
+    auto promptHash = (juce::uint32)normalised.hashCode();
+    auto sketch = makeSketch(normalised);
+
+    auto* header = getHeader();
+    Record* best = nullptr;
+    float bestSimilarity = minSimilarity;
+    bool exact = false;
+
+    for( int index = 0; index < capacity; ++index )
+    {
+        auto* record = getRecord(index);
+        if( record->lastUsed == 0 || record->stateFingerprint != stateFingerprint )
+            continue;
+
+        // a cut record can't be told apart from another prompt that starts the same way
+        if( record->truncated == 0 && record->promptHash == promptHash && getStoredPrompt(*record) == normalised )
+        {
+            best = record;
+            bestSimilarity = 1.f;
+            exact = true;
+            break;
+        }
+
+        auto similarity = getSimilarity(sketch, record->sketch);
+        if( similarity >= bestSimilarity && ! differInDirection(normalised, getStoredPrompt(*record)) )
+        {
+            best = record;
+            bestSimilarity = similarity;
+        }
+    }
+
+    if( best == nullptr )
+    {
+        ++header->misses;
+        return {};
+    }
+
+    if( exact )
+        ++header->hits;
+    else
+        ++header->fuzzyHits;
+
+    best->lastUsed = ++header->clock;
+
+    Match match;
+    match.prompt = getStoredPrompt(*best) + (best->truncated != 0 ? "..." : "");
+    match.similarity = bestSimilarity;
+    match.exact = exact;
+
+    for( int value = 0; value < juce::jmin((int)best->numValues, maxValues); ++value )
+        match.preset.set(best->indices[value], best->values[value]);
+
+    return match;
+}
+
+void PromptPresetCache::store(const juce::String& prompt, juce::uint64 stateFingerprint, const ParameterPreset& preset)
+{
+    const juce::ScopedLock sl(lock);
+    if( mappedFile == nullptr )
+        return;
+
+    auto normalised = normalisePrompt(prompt);
+    if( normalised.isEmpty() )
+        return;
+
+    const juce::InterProcessLock::ScopedLockType fl(fileLock);
+    if( ! fl.isLocked() )
+        return;
+
+    auto promptHash = (juce::uint32)normalised.hashCode();
+    auto key = getStoredPrefix(normalised);
+    const bool truncated = key != normalised;
+
+    // the same request replaces its old answer, otherwise an empty record or the least recently used
+    Record* target = nullptr;
+    for( int index = 0; index < capacity; ++index )
+    {
+        auto* record = getRecord(index);
+        if( record->lastUsed != 0 && record->promptHash == promptHash && record->stateFingerprint == stateFingerprint
+            && (record->truncated != 0) == truncated && getStoredPrompt(*record) == key )
+        {
+            target = record;
+            break;
+        }
+
+        if( target == nullptr || record->lastUsed < target->lastUsed )
+            target = record;
+    }
+
+    Record record {};
+    record.stateFingerprint = stateFingerprint;
+    record.promptHash = promptHash;
+    record.lastUsed = ++getHeader()->clock;
+
+    auto sketch = makeSketch(normalised);
+    std::copy(sketch.begin(), sketch.end(), record.sketch);
+
+    // not null-terminated: promptLength says where it ends
+    record.promptLength = (juce::uint16)key.getNumBytesAsUTF8();
+    record.truncated = truncated ? 1 : 0;
+    std::memcpy(record.prompt, key.toRawUTF8(), record.promptLength);
+
+    for( int index = 0; index < ParameterPreset::maxParameters && record.numValues < maxValues; ++index )
+    {
+        if( preset.has(index) )
+        {
+            record.indices[record.numValues] = (juce::uint16)index;
+            record.values[record.numValues] = preset.get(index);
+            ++record.numValues;
+        }
+    }
+
+    if( record.numValues > 0 )
+        *target = record;
+}
+
+PromptPresetCache::Stats PromptPresetCache::getStats() const
+{
+    const juce::ScopedLock sl(lock);
+
+    Stats stats;
+    if( mappedFile == nullptr )
+        return stats;
+
+    const juce::InterProcessLock::ScopedLockType fl(fileLock);
+
+    auto* header = getHeader();
+    stats.hits = header->hits;
+    stats.fuzzyHits = header->fuzzyHits;
+    stats.misses = header->misses;
+
+    for( int index = 0; index < capacity; ++index )
+        stats.numEntries += getRecord(index)->lastUsed != 0 ? 1 : 0;
+
+    return stats;
+}
+
+juce::String PromptPresetCache::normalisePrompt(const juce::String& prompt)
+{
+    // lower case words separated by single spaces, without the punctuation
+    juce::String result;
+    bool needsSpace = false;
+
+    for( auto c : prompt.toLowerCase() )
+    {
+        if( ! juce::CharacterFunctions::isLetterOrDigit(c) )
+        {
+            needsSpace = result.isNotEmpty();
+            continue;
+        }
+
+        if( needsSpace )
+            result << ' ';
+
+        result << juce::String::charToString(c);
+        needsSpace = false;
+    }
+
+    return result;
+}
+
+juce::String PromptPresetCache::getStoredPrefix(const juce::String& normalisedPrompt)
+{
+    auto key = normalisedPrompt;
+
+    // a prompt too long to store whole is cut at a character, never inside one
+    while( (int)key.getNumBytesAsUTF8() > maxPromptBytes )
+        key = key.dropLastCharacters(1);
+
+    return key.trimEnd();
+}
+
+juce::String PromptPresetCache::getStoredPrompt(const Record& record)
+{
+    return juce::String::fromUTF8(record.prompt, juce::jmin((int)record.promptLength, maxPromptBytes));
+}
+
+PromptPresetCache::Sketch PromptPresetCache::makeSketch(const juce::String& normalisedPrompt)
+{
+    Sketch sketch {};
+
+    // padded, so the start and end of each word count too
+    auto text = " " + normalisedPrompt + " ";
+
+    for( int start = 0; start + 3 <= text.length(); ++start )
+    {
+        // FNV-1a over the trigram, folded down to one of the 256 bits
+        juce::uint32 hash = 2166136261u;
+        for( int offset = 0; offset < 3; ++offset )
+            hash = (hash ^ (juce::uint32)text[start + offset]) * 16777619u;
+
+        auto bit = (hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) & 255u;
+        sketch[bit / 64] |= (juce::uint64)1 << (bit % 64);
+    }
+
+    return sketch;
+}
+
+float PromptPresetCache::getSimilarity(const Sketch& a, const juce::uint64 (&b)[4])
+{
+    // Jaccard similarity of the two trigram sets
+    int numShared = 0, numEither = 0;
+
+    for( size_t word = 0; word < a.size(); ++word )
+    {
+        numShared += juce::countNumberOfBits(a[word] & b[word]);
+        numEither += juce::countNumberOfBits(a[word] | b[word]);
+    }
+
+    return numEither > 0 ? (float)numShared / (float)numEither : 0.f;
+}
+
+bool PromptPresetCache::differInDirection(const juce::String& normalisedPrompt, const juce::String& otherPrompt)
+{
+    auto words = juce::StringArray::fromTokens(normalisedPrompt, " ", {});
+    auto otherWords = juce::StringArray::fromTokens(otherPrompt, " ", {});
+
+    for( const auto& word : words )
+        if( ! otherWords.contains(word) && isDirectionWord(word) )
+            return true;
+
+    for( const auto& word : otherWords )
+        if( ! words.contains(word) && isDirectionWord(word) )
+            return true;
+
+    return false;
+}
+
+bool PromptPresetCache::isDirectionWord(const juce::String& word)
+{
+    static const juce::StringArray directionWords
+    {
+        "more", "less", "add", "remove", "increase", "decrease", "raise", "lower", "reduce", "boost", "cut",
+        "up", "down", "no", "not", "without", "too", "much", "little", "bit", "max", "min", "off", "on"
+    };
+
+    // comparatives: brighter / darker, louder / quieter, wetter / drier...
+    return directionWords.contains(word) || (word.length() > 4 && word.endsWith("er"));
+}
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    PromptCache.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include <array>
+#include <optional>
+
+/**
+ Remembers which settings the model answered a prompt with, so asking for the same thing
+ again (or nearly the same thing) doesn't need another round trip.
+
+ Entries are keyed by the normalised prompt and a fingerprint of the quantised settings it
+ was asked from, since a reply only holds the values the model changed. A prompt that isn't
+ an exact match can still hit through a 256 bit sketch of its character trigrams, which
+ catches rewordings like "warmer vocals" / "make the vocals warmer". Two prompts whose
+ differing words include one that gives a direction ("more" / "less", "brighter" / "darker",
+ "add" / "remove") never match that way, however similar the rest of them is. A record only
+ has room for the start of a long prompt, so those are matched by their hash and sketch
+ alone and never count as exact.
+
+ The cache is a fixed size file of fixed size records in the user's application data
+ folder, memory-mapped and read and written in place. When it's full the least recently
+ used entry makes room. One instance is shared by every plugin instance in the process,
+ through a juce::SharedResourcePointer, and an InterProcessLock keeps hosts that run plugins
+ in separate processes from using the file at the same time.
+ */
+class PromptPresetCache
+{
+public:
+    static constexpr int capacity = 256;
+
+    PromptPresetCache();
+    explicit PromptPresetCache(const juce::File& cacheFile);
+
+    struct Match
+    {
+        ParameterPreset preset;
+        juce::String prompt;        // the one stored, normalised
+        float similarity = 0;       // of the trigram sketches
+        bool exact = false;
+    };
+
+    /** the best entry for 'prompt' asked from the settings 'stateFingerprint', counting a hit or a miss */
+    std::optional<Match> find(const juce::String& prompt, juce::uint64 stateFingerprint);
+
+    void store(const juce::String& prompt, juce::uint64 stateFingerprint, const ParameterPreset& preset);
+
+    struct Stats
+    {
+        int numEntries = 0;
+        juce::uint32 hits = 0, fuzzyHits = 0, misses = 0;   // since the cache file was created
+    };
+
+    Stats getStats() const;
+
+    static juce::File getDefaultFile();
+    static juce::String normalisePrompt(const juce::String& prompt);
+private:
+    static constexpr juce::uint32 magic = 0x70434747;   // "GGCp"
+    static constexpr juce::uint32 version = 2;
+
+    // below this a fuzzy match is more likely a different request
+    static constexpr float minSimilarity = 0.8f;
+
+    static constexpr int maxPromptBytes = 91;
+    static constexpr int maxValues = 48;
+
+    struct Header
+    {
+        juce::uint32 magic, version, capacity, clock;
+        juce::uint32 hits, fuzzyHits, misses, reserved;
+    };
+
+    struct Record
+    {
+        juce::uint64 stateFingerprint;
+        juce::uint64 sketch[4];
+        juce::uint32 promptHash;    // of the whole normalised prompt, even when only the start of it is kept
+        juce::uint32 lastUsed;      // 0 for an empty record
+        juce::uint16 numValues, promptLength;
+        juce::uint8 truncated;
+        char prompt[maxPromptBytes];
+        juce::uint16 indices[maxValues];
+        float values[maxValues];
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<Record>);
+    static_assert(sizeof(Header) == 32 && sizeof(Record) % 8 == 0);
+
+    using Sketch = std::array<juce::uint64, 4>;
+
+    juce::File file;
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    juce::CriticalSection lock;
+    mutable juce::InterProcessLock fileLock { "GenreGeniePromptCache" };
+
+    bool open();
+    Header* getHeader() const;
+    Record* getRecord(int index) const;
+
+    /** as much of a normalised prompt as fits in a record */
+    static juce::String getStoredPrefix(const juce::String& normalisedPrompt);
+    static juce::String getStoredPrompt(const Record& record);
+    static Sketch makeSketch(const juce::String& normalisedPrompt);
+    static float getSimilarity(const Sketch& a, const juce::uint64 (&b)[4]);
+
+    /** whether the words only one of the two prompts has include one that says which way to go */
+    static bool differInDirection(const juce::String& normalisedPrompt, const juce::String& otherPrompt);
+    static bool isDirectionWord(const juce::String& word);
+};
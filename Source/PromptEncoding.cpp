@@ -0,0 +1,357 @@
+/*
+  ==============================================================================
+
+    PromptEncoding.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "PromptEncoding.h"
+#include "ProcessingChain.h"
+#include <cmath>
+
+namespace
+{
+    struct PromptKey
+    {
+        const char* parameterID;
+        const char* key;
+        const char* unit;
+    };
+
+    // what the model gets to see and change, in the order it sees it
+    const PromptKey promptKeys[] =
+    {
+        { "LowCut Freq", "lc", "Hz" },
+        { "LowCut Slope", "lcs", "" },
+        { "Peak Freq", "pf", "Hz" },
+        { "Peak Gain", "pg", "dB" },
+        { "Peak Quality", "pq", "Q" },
+        { "HighCut Freq", "hc", "Hz" },
+        { "HighCut Slope", "hcs", "" },
+
+        { "Comp Threshold", "cth", "dB" },
+        { "Comp Ratio", "cra", ":1" },
+        { "Comp Attack", "cat", "ms" },
+        { "Comp Release", "crl", "ms" },
+
+        { "Comp Multiband", "mb", "" },
+        { "Comp Bands", "mbn", "" },
+        { "Comp Crossover Low", "mxl", "Hz" },
+        { "Comp Crossover Mid", "mxm", "Hz" },
+        { "Comp Crossover High", "mxh", "Hz" },
+        { "Comp Band1 Threshold", "b1t", "dB" },
+        { "Comp Band1 Ratio", "b1r", ":1" },
+        { "Comp Band1 Attack", "b1a", "ms" },
+        { "Comp Band1 Release", "b1l", "ms" },
+        { "Comp Band2 Threshold", "b2t", "dB" },
+        { "Comp Band2 Ratio", "b2r", ":1" },
+        { "Comp Band2 Attack", "b2a", "ms" },
+        { "Comp Band2 Release", "b2l", "ms" },
+        { "Comp Band3 Threshold", "b3t", "dB" },
+        { "Comp Band3 Ratio", "b3r", ":1" },
+        { "Comp Band3 Attack", "b3a", "ms" },
+        { "Comp Band3 Release", "b3l", "ms" },
+        { "Comp Band4 Threshold", "b4t", "dB" },
+        { "Comp Band4 Ratio", "b4r", ":1" },
+        { "Comp Band4 Attack", "b4a", "ms" },
+        { "Comp Band4 Release", "b4l", "ms" },
+
+        { "Distortion Amount", "dst", "" },
+
+        { "Delay Time", "dt", "ms" },
+        { "Delay Feedback", "dfb", "" },
+        { "Delay Mix", "dmx", "" },
+
+        { "Reverb Size", "rsz", "" },
+        { "Reverb Decay", "rdc", "s" },
+        { "Reverb Mix", "rmx", "" },
+
+        { "Chain Order", "ord", "" }
+    };
+}
+
+PromptParameterEncoding::PromptParameterEncoding(juce::AudioProcessorValueTreeState& apvts)
+{
+    for( const auto& promptKey : promptKeys )
+    {
+        auto* parameter = apvts.getParameter(promptKey.parameterID);
+        jassert(parameter != nullptr);
+
+        if( parameter != nullptr )
+            entries.push_back({ promptKey.key, promptKey.unit, parameter });
+    }
+
+    buildIDTable();
+}
+
+juce::String PromptParameterEncoding::getSchema() const
+{
+    juce::String schema;
+    schema << "Parameters, one per line as: key, name, unit, range or choices.\n";
+
+    for( const auto& entry : entries )
+    {
+        schema << entry.key << ", " << entry.parameter->getName(64) << ", " << (entry.unit.isEmpty() ? "-" : entry.unit) << ", ";
+
+        if( auto* choice = dynamic_cast<juce::AudioParameterChoice*>(entry.parameter) )
+        {
+            // the chain order has 120 choices, so describe it rather than list them
+            if( entry.parameter->getParameterID() == "Chain Order" )
+            {
+                schema << "the five stages in processing order, any order, e.g. \"" << getChainOrderName(0) << "\"";
+            }
+            else
+            {
+                for( int index = 0; index < choice->choices.size(); ++index )
+                    schema << (index > 0 ? " " : "") << index << "=" << choice->choices[index].removeCharacters(" ");
+            }
+        }
+        else if( dynamic_cast<juce::AudioParameterBool*>(entry.parameter) != nullptr )
+        {
+            schema << "0=off 1=on";
+        }
+        else
+        {
+            const auto& range = entry.parameter->getNormalisableRange();
+            schema << formatValue(range.start, range) << ".." << formatValue(range.end, range);
+        }
+
+        schema << "\n";
+    }
+
+    schema << "\nEach message ends with the current settings as key=value pairs. Reply with a ```json block holding only "
+              "the parameters you change, as {\"set\":[{\"id\":\"<key>\",\"v\":<value>}]}, using a choice's number, "
+              "then a plain text explanation after the block. If you are asked for a JSON reply instead, put the "
+              "explanation in its \"explanation\" field. Values outside a range are clamped, and you will be told "
+              "about any that had to be changed or were ignored.";
+
+    return schema;
+}
+
+juce::String PromptParameterEncoding::encodeState(const ParameterPreset& pending) const
+{
+    juce::StringArray pairs;
+
+    for( const auto& entry : entries )
+    {
+        const auto& range = entry.parameter->getNormalisableRange();
+        auto index = entry.parameter->getParameterIndex();
+        auto value = pending.has(index) ? pending.get(index) : range.convertFrom0to1(entry.parameter->getValue());
+
+        if( entry.parameter->getParameterID() == "Chain Order" )
+            pairs.add(entry.key + "=\"" + entry.parameter->getText(range.convertTo0to1(value), 64) + "\"");
+        else
+            pairs.add(entry.key + "=" + formatValue(value, range));
+    }
+
+    return pairs.joinIntoString(" ");
+}
+
+juce::uint64 PromptParameterEncoding::getStateFingerprint(int numSteps) const
+{
+    // FNV-1a over the quantised values
+    juce::uint64 hash = 14695981039346656037ull;
+
+    for( const auto& entry : entries )
+    {
+        auto step = (juce::uint64)juce::roundToInt(entry.parameter->getValue() * (float)(numSteps - 1));
+        hash = (hash ^ step) * 1099511628211ull;
+    }
+
+    return hash;
+}
+
+juce::var PromptParameterEncoding::getResponseSchema(int numCandidates) const
+{
+    auto makeObject = [](std::initializer_list<std::pair<const char*, juce::var>> properties)
+    {
+        juce::DynamicObject::Ptr object = new juce::DynamicObject();
+        for( const auto& property : properties )
+            object->setProperty(property.first, property.second);
+
+        return juce::var(object.get());
+    };
+
+    juce::Array<juce::var> keys;
+    for( const auto& entry : entries )
+        keys.add(entry.key);
+
+    juce::Array<juce::var> valueTypes { "number", "string" };
+
+    // strict mode wants every property listed as required and nothing else allowed
+    auto setting = makeObject({ { "type", "object" },
+                                { "properties", makeObject({ { "id", makeObject({ { "type", "string" }, { "enum", keys } }) },
+                                                             { "v", makeObject({ { "type", valueTypes } }) } }) },
+                                { "required", juce::Array<juce::var> { "id", "v" } },
+                                { "additionalProperties", false } });
+
+    auto settings = makeObject({ { "type", "array" }, { "items", setting } });
+
+    if( numCandidates > 1 )
+    {
+        auto candidate = makeObject({ { "type", "object" },
+                                      { "properties", makeObject({ { "name", makeObject({ { "type", "string" } }) },
+                                                                   { "set", settings } }) },
+                                      { "required", juce::Array<juce::var> { "name", "set" } },
+                                      { "additionalProperties", false } });
+
+        return makeObject({ { "type", "object" },
+                            { "properties", makeObject({ { "candidates", makeObject({ { "type", "array" }, { "items", candidate } }) },
+                                                         { "explanation", makeObject({ { "type", "string" } }) } }) },
+                            { "required", juce::Array<juce::var> { "candidates", "explanation" } },
+                            { "additionalProperties", false } });
+    }
+
+    return makeObject({ { "type", "object" },
+                        { "properties", makeObject({ { "set", settings },
+                                                     { "explanation", makeObject({ { "type", "string" } }) } }) },
+                        { "required", juce::Array<juce::var> { "set", "explanation" } },
+                        { "additionalProperties", false } });
+}
+
+juce::String PromptParameterEncoding::getCandidatesRequest(int numCandidates)
+{
+    return "This time give " + juce::String(numCandidates) + " clearly different takes instead of one, as "
+           "{\"candidates\":[{\"name\":\"<two or three words>\",\"set\":[{\"id\":\"<key>\",\"v\":<value>}]}]} "
+           "in place of the usual object, each changing the current settings on its own, and explain how they differ.";
+}
+
+PromptParameterEncoding::Decoded PromptParameterEncoding::decode(const ReplyParameter& parameter) const
+{
+    Decoded result;
+
+    const auto* entry = find(parameter.id);
+    if( entry == nullptr )
+    {
+        result.problem = "\"" + parameter.id + "\" isn't a parameter, ignored";
+        return result;
+    }
+
+    const auto& range = entry->parameter->getNormalisableRange();
+    double value = parameter.number;
+
+    if( parameter.type == ReplyParameter::Type::text )
+    {
+        auto* choice = dynamic_cast<juce::AudioParameterChoice*>(entry->parameter);
+        if( choice == nullptr )
+        {
+            result.problem = entry->key + " needs a number, \"" + parameter.text + "\" ignored";
+            return result;
+        }
+
+        // choices may come back as their text, which is the only way the chain order ever does
+        auto wanted = normaliseChoice(parameter.text);
+        int index = -1;
+
+        for( int i = 0; i < choice->choices.size() && index < 0; ++i )
+            if( normaliseChoice(choice->choices[i]) == wanted )
+                index = i;
+
+        if( index < 0 )
+        {
+            result.problem = entry->key + " has no choice \"" + parameter.text + "\", ignored";
+            return result;
+        }
+
+        value = index;
+    }
+    else if( parameter.type != ReplyParameter::Type::number )
+    {
+        result.problem = entry->key + " has no value, ignored";
+        return result;
+    }
+
+    if( ! std::isfinite(value) )
+    {
+        result.problem = entry->key + " isn't a finite number, ignored";
+        return result;
+    }
+
+    const auto wanted = static_cast<float>(value);
+    auto legal = juce::jlimit(range.start, range.end, wanted);
+
+    if( dynamic_cast<juce::AudioParameterBool*>(entry->parameter) != nullptr )
+        legal = legal >= 0.5f ? 1.f : 0.f;
+    else if( dynamic_cast<juce::AudioParameterChoice*>(entry->parameter) != nullptr )
+        legal = (float)juce::roundToInt(legal);
+    else
+        legal = range.snapToLegalValue(legal);
+
+    // snapping to the parameter's steps isn't worth mentioning, landing somewhere else is
+    if( wanted < range.start || wanted > range.end )
+        result.problem = entry->key + "=" + formatValue(wanted, range) + " is outside " + formatValue(range.start, range)
+                       + ".." + formatValue(range.end, range) + ", used " + formatValue(legal, range);
+
+    result.parameterIndex = entry->parameter->getParameterIndex();
+    result.value = legal;
+    return result;
+}
+
+void PromptParameterEncoding::buildIDTable()
+{
+    for( juce::uint32 seed = 1;; ++seed )
+    {
+        idTable.fill(-1);
+        bool collided = false;
+
+        for( size_t index = 0; index < entries.size() && ! collided; ++index )
+        {
+            for( const auto& id : { entries[index].key, entries[index].parameter->getParameterID() } )
+            {
+                auto& slot = idTable[hashID(id, seed) % idTableSize];
+                collided = collided || (slot >= 0 && slot != (juce::int16)index);
+                slot = (juce::int16)index;
+            }
+        }
+
+        if( ! collided )
+        {
+            idHashSeed = seed;
+            return;
+        }
+    }
+}
+
+juce::uint32 PromptParameterEncoding::hashID(const juce::String& id, juce::uint32 seed)
+{
+    // FNV-1a with the seed mixed into the basis, then avalanched so the low bits pick the slot
+    auto hash = 2166136261u ^ (seed * 0x9e3779b9u);
+
+    for( auto* c = id.toRawUTF8(); *c != 0; ++c )
+        hash = (hash ^ (juce::uint8)*c) * 16777619u;
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+const PromptParameterEncoding::Entry* PromptParameterEncoding::find(const juce::String& keyOrID) const
+{
+    auto slot = idTable[hashID(keyOrID, idHashSeed) % idTableSize];
+    if( slot < 0 )
+        return nullptr;
+
+    // anything else can land in a used slot, so it still has to be the same string
+    const auto& entry = entries[(size_t)slot];
+    return entry.key == keyOrID || entry.parameter->getParameterID() == keyOrID ? &entry : nullptr;
+}
+
+juce::String PromptParameterEncoding::formatValue(float value, const juce::NormalisableRange<float>& range)
+{
+    // no more digits than the parameter can actually resolve
+    const auto decimals = range.interval >= 1.f ? 0 : range.interval >= 0.1f ? 1 : range.interval >= 0.01f ? 2 : 3;
+    auto text = juce::String(value, decimals);
+
+    if( text.containsChar('.') )
+        text = text.trimCharactersAtEnd("0").trimCharactersAtEnd(".");
+
+    return text;
+}
+
+juce::String PromptParameterEncoding::normaliseChoice(const juce::String& choice)
+{
+    return choice.removeCharacters(" ").toLowerCase();
+}
@@ -0,0 +1,99 @@
+/*
+  ==============================================================================
+
+    PromptEncoding.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+#include "StreamingResponseParser.h"
+#include <array>
+#include <vector>
+
+/**
+ A compact way of talking to the model about the parameters. The schema (a short key, the
+ name, unit and range or choices of every parameter) goes into the system prompt once. After
+ that each turn only carries "key=value" pairs, and the model answers with just the values
+ it changes, using the same keys:
+
+     ```json
+     {"set":[{"id":"pf","v":750},{"id":"pg","v":-3}]}
+     ```
+
+ With structured output the reply is that object on its own, with the explanation in it.
+ */
+struct PromptParameterEncoding
+{
+    explicit PromptParameterEncoding(juce::AudioProcessorValueTreeState& apvts);
+
+    /** the parameter table and the reply format, for the system prompt */
+    juce::String getSchema() const;
+
+    /**
+     every parameter's current value, e.g. "lc=20 lcs=0 pf=750 ...", with any values in 'pending'
+     in place of the ones they're about to replace
+     */
+    juce::String encodeState(const ParameterPreset& pending = {}) const;
+
+    /**
+     a hash of the current values, each quantised to 'numSteps' across its range, so settings
+     that only differ by a nudge share a fingerprint
+     */
+    juce::uint64 getStateFingerprint(int numSteps = 16) const;
+
+    /** the JSON schema a structured output reply has to match, one with that many candidates if more than one */
+    juce::var getResponseSchema(int numCandidates = 1) const;
+
+    /**
+     asks for several alternatives in one reply, each a named set of changes:
+     {"candidates":[{"name":"Warm","set":[...]},{"name":"Bright","set":[...]}]}
+     */
+    static juce::String getCandidatesRequest(int numCandidates);
+
+    struct Decoded
+    {
+        int parameterIndex = -1;
+        float value = 0;
+
+        // why the value was rejected, or what was done to make it fit, for telling the model
+        juce::String problem;
+
+        bool isValid() const { return parameterIndex >= 0; }
+    };
+
+    /**
+     maps one object from a reply to a parameter index and a legal plain value: clamped into the
+     range and snapped to its steps, a choice rounded to the nearest one (or matched by its text).
+     Understands the compact {"id":"pf","v":750} and the older {"id":"Peak Freq","current":750}.
+     */
+    Decoded decode(const ReplyParameter& parameter) const;
+private:
+    struct Entry
+    {
+        juce::String key, unit;
+        juce::RangedAudioParameter* parameter = nullptr;
+    };
+
+    std::vector<Entry> entries;
+
+    /*
+     every key and parameter ID hashes to its own slot, which holds the index of its entry (or -1),
+     so a lookup is one hash and one string comparison. The seed is whichever first gives no collisions.
+     */
+    static constexpr int idTableSize = 4096;
+    std::array<juce::int16, idTableSize> idTable;
+    juce::uint32 idHashSeed = 0;
+
+    void buildIDTable();
+    static juce::uint32 hashID(const juce::String& id, juce::uint32 seed);
+
+    const Entry* find(const juce::String& keyOrID) const;
+
+    static juce::String formatValue(float value, const juce::NormalisableRange<float>& range);
+    static juce::String normaliseChoice(const juce::String& choice);
+};
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    SidechainCompressor.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+ The same gain computer as juce::dsp::Compressor, but with its detector listening to a
+ separate key signal, high-passed first so the low end of the key doesn't dominate.
+ The key is read straight from the sidechain bus, sample by sample, so nothing is copied.
+ */
+template<typename SampleType>
+struct SidechainCompressor
+{
+    using Block = juce::dsp::AudioBlock<SampleType>;
+    using KeyBlock = juce::dsp::AudioBlock<const SampleType>;
+
+    void prepare(const juce::dsp::ProcessSpec& spec)
+    {
+        envelopeFilter.prepare(spec);
+        envelopeFilter.setLevelCalculationType(juce::dsp::BallisticsFilterLevelCalculationType::RMS);
+
+        keyFilter.prepare(spec);
+        keyFilter.setType(juce::dsp::StateVariableTPTFilterType::highpass);
+
+        update();
+    }
+
+    void reset()
+    {
+        envelopeFilter.reset();
+        keyFilter.reset();
+    }
+
+    void setThreshold(SampleType newThresholdInDecibels) { thresholddB = newThresholdInDecibels; update(); }
+    void setRatio(SampleType newRatio) { ratio = juce::jmax(SampleType(1), newRatio); update(); }
+    void setAttack(SampleType newAttackInMs) { attackTime = newAttackInMs; update(); }
+    void setRelease(SampleType newReleaseInMs) { releaseTime = newReleaseInMs; update(); }
+
+    void setKeyHighPassFrequency(SampleType frequency) { keyFilter.setCutoffFrequency(frequency); }
+
+    /** 'key' must have at least one channel; a mono key drives every channel of 'block' */
+    void process(Block& block, const KeyBlock& key)
+    {
+        jassert(key.getNumChannels() > 0 && key.getNumSamples() >= block.getNumSamples());
+
+        for( size_t ch = 0; ch < block.getNumChannels(); ++ch )
+        {
+            const auto channel = (int)ch;
+            const auto* keyData = key.getChannelPointer(juce::jmin(ch, key.getNumChannels() - 1));
+            auto* data = block.getChannelPointer(ch);
+
+            for( size_t i = 0; i < block.getNumSamples(); ++i )
+            {
+                auto level = envelopeFilter.processSample(channel, keyFilter.processSample(channel, keyData[i]));
+
+                if( level > threshold )
+                    data[i] *= std::pow(level * thresholdInverse, ratioInverse - SampleType(1));
+            }
+        }
+    }
+private:
+    juce::dsp::BallisticsFilter<SampleType> envelopeFilter;
+    juce::dsp::StateVariableTPTFilter<SampleType> keyFilter;
+
+    SampleType thresholddB = 0, threshold = 1, thresholdInverse = 1;
+    SampleType ratio = 1, ratioInverse = 1;
+    SampleType attackTime = 1, releaseTime = 100;
+
+    void update()
+    {
+        threshold = juce::Decibels::decibelsToGain(thresholddB, SampleType(-200));
+        thresholdInverse = SampleType(1) / threshold;
+        ratioInverse = SampleType(1) / ratio;
+
+        envelopeFilter.setAttackTime(attackTime);
+        envelopeFilter.setReleaseTime(releaseTime);
+    }
+};
@@ -0,0 +1,554 @@
+/*
+  ==============================================================================
+
+    StreamingResponseParser.cpp
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#include "StreamingResponseParser.h"
+
+namespace
+{
+    // the character an escape sequence stands for, for everything but \u
+    juce::juce_wchar getEscapedCharacter(juce::juce_wchar c)
+    {
+        switch( c )
+        {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'b': return '\b';
+            case 'f': return '\f';
+            default:  return c;
+        }
+    }
+
+    bool isHighSurrogate(juce::juce_wchar c)
+    {
+        return c >= 0xd800 && c <= 0xdbff;
+    }
+
+    bool isLowSurrogate(juce::juce_wchar c)
+    {
+        return c >= 0xdc00 && c <= 0xdfff;
+    }
+
+    // a character outside the BMP, which JSON escapes as a pair of UTF-16 surrogates
+    juce::juce_wchar combineSurrogates(juce::juce_wchar high, juce::juce_wchar low)
+    {
+        return 0x10000 + ((high - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    // the four digits of a \u escape, leaving p after them, or -1 if they aren't all there
+    int readHexDigits(juce::String::CharPointerType& p)
+    {
+        int code = 0;
+
+        for( int digit = 0; digit < 4; ++digit )
+        {
+            // the terminator isn't a hex digit either, so this never runs off the end
+            auto value = juce::CharacterFunctions::getHexDigitValue(*p);
+            if( value < 0 )
+                return -1;
+
+            code = code * 16 + value;
+            ++p;
+        }
+
+        return code;
+    }
+
+    constexpr juce::juce_wchar replacementCharacter = 0xfffd;
+}
+
+bool ReplyParameter::parse(juce::String::CharPointerType json, ReplyParameter& result)
+{
+    result = {};
+
+    auto p = json.findEndOfWhitespace();
+    if( p.getAndAdvance() != '{' )
+        return false;
+
+    // reads the string p is on, leaving p after its closing quote
+    auto readString = [&p](juce::String& string)
+    {
+        if( p.getAndAdvance() != '"' )
+            return false;
+
+        for( ;; )
+        {
+            auto c = p.getAndAdvance();
+            if( c == 0 )
+                return false;
+
+            if( c == '"' )
+                return true;
+
+            if( c == '\\' )
+            {
+                c = p.getAndAdvance();
+                if( c == 'u' )
+                {
+                    auto code = readHexDigits(p);
+                    if( code < 0 )
+                        return false;
+
+                    c = (juce::juce_wchar)code;
+
+                    if( isHighSurrogate(c) )
+                    {
+                        // only taken if the second half really follows
+                        auto next = p;
+                        int low = -1;
+                        if( next.getAndAdvance() == '\\' && next.getAndAdvance() == 'u' )
+                            low = readHexDigits(next);
+
+                        if( low >= 0 && isLowSurrogate((juce::juce_wchar)low) )
+                        {
+                            c = combineSurrogates(c, (juce::juce_wchar)low);
+                            p = next;
+                        }
+                        else
+                        {
+                            c = replacementCharacter;
+                        }
+                    }
+                    else if( isLowSurrogate(c) )
+                    {
+                        c = replacementCharacter;
+                    }
+                }
+                else
+                {
+                    c = getEscapedCharacter(c);
+                }
+            }
+
+            string += c;
+        }
+    };
+
+    // steps over an object or array, strings and all
+    auto skipContainer = [&p]()
+    {
+        int depth = 0;
+        bool inString = false, escaped = false;
+
+        for( ;; )
+        {
+            auto c = p.getAndAdvance();
+            if( c == 0 )
+                return false;
+
+            if( inString )
+            {
+                if( escaped )           escaped = false;
+                else if( c == '\\' )    escaped = true;
+                else if( c == '"' )     inString = false;
+                continue;
+            }
+
+            if( c == '"' )                      inString = true;
+            else if( c == '{' || c == '[' )     ++depth;
+            else if( (c == '}' || c == ']') && --depth == 0 )
+                return true;
+        }
+    };
+
+    for( ;; )
+    {
+        p = p.findEndOfWhitespace();
+        if( *p == '}' )
+            return true;
+
+        juce::String key;
+        if( ! readString(key) )
+            return false;
+
+        p = p.findEndOfWhitespace();
+        if( p.getAndAdvance() != ':' )
+            return false;
+
+        p = p.findEndOfWhitespace();
+
+        // "v" wins over the older names if a reply has both
+        const bool isValue = key == "v" || ((key == "current" || key == "value") && result.type == Type::missing);
+
+        auto c = *p;
+        if( c == '"' )
+        {
+            juce::String string;
+            if( ! readString(string) )
+                return false;
+
+            if( key == "id" )
+                result.id = string.trim();
+            else if( isValue )
+            {
+                result.type = Type::text;
+                result.text = string;
+            }
+        }
+        else if( c == '-' || juce::CharacterFunctions::isDigit(c) )
+        {
+            auto start = p;
+            while( *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E' || juce::CharacterFunctions::isDigit(*p) )
+                ++p;
+
+            if( isValue )
+            {
+                result.type = Type::number;
+                result.number = juce::String(start, p).getDoubleValue();
+            }
+        }
+        else if( p.compareUpTo(juce::CharPointer_ASCII("true"), 4) == 0 || p.compareUpTo(juce::CharPointer_ASCII("false"), 5) == 0 )
+        {
+            const bool value = c == 't';
+            p += value ? 4 : 5;
+
+            if( isValue )
+            {
+                result.type = Type::number;
+                result.number = value ? 1.0 : 0.0;
+            }
+        }
+        else if( p.compareUpTo(juce::CharPointer_ASCII("null"), 4) == 0 )
+        {
+            p += 4;
+
+            if( isValue )
+                result.type = Type::other;
+        }
+        else if( c == '{' || c == '[' )
+        {
+            if( ! skipContainer() )
+                return false;
+
+            if( isValue )
+                result.type = Type::other;
+        }
+        else
+        {
+            return false;
+        }
+
+        p = p.findEndOfWhitespace();
+        if( *p == ',' )
+            ++p;
+        else if( *p != '}' )
+            return false;
+    }
+}
+
+ReplyParameter ReplyParameter::fromVar(const juce::var& object)
+{
+    ReplyParameter result;
+    result.id = object.getProperty("id", {}).toString().trim();
+
+    auto value = object.hasProperty("v") ? object.getProperty("v", {})
+               : object.hasProperty("current") ? object.getProperty("current", {})
+               : object.getProperty("value", {});
+
+    if( value.isBool() || value.isInt() || value.isInt64() || value.isDouble() )
+    {
+        result.type = Type::number;
+        result.number = static_cast<double>(value);
+    }
+    else if( value.isString() )
+    {
+        result.type = Type::text;
+        result.text = value.toString();
+    }
+    else if( ! value.isVoid() )
+    {
+        result.type = Type::other;
+    }
+
+    return result;
+}
+
+//==============================================================================
+void StreamingResponseParser::feed(const juce::String& piece)
+{
+    juce::String text;
+
+    for( auto c : piece )
+    {
+        switch( state )
+        {
+            case State::Start:
+                if( juce::CharacterFunctions::isWhitespace(c) )
+                    break;
+
+                // a reply that opens with a brace is all JSON, as a structured output request gets back
+                if( c == '{' )
+                {
+                    state = State::Json;
+                    bareJson = true;
+                    handleJsonCharacter(c, text);
+                    break;
+                }
+
+                state = State::Text;
+                handleTextCharacter(c, text);
+                break;
+            case State::Text:
+                handleTextCharacter(c, text);
+                break;
+            case State::FenceInfo:
+                if( c == '\n' )
+                    state = State::Json;
+                break;
+            case State::Json:
+                handleJsonCharacter(c, text);
+                break;
+        }
+    }
+
+    flushText(text);
+}
+
+void StreamingResponseParser::finish()
+{
+    juce::String text;
+
+    if( state == State::Text )
+        text = juce::String::repeatedString("`", pendingBackticks);
+
+    pendingBackticks = 0;
+    flushText(text);
+}
+
+void StreamingResponseParser::reset()
+{
+    state = State::Start;
+    bareJson = false;
+    pendingBackticks = 0;
+    containers.clear();
+    inString = escaped = false;
+    currentObject.clear();
+    objectDepth = -1;
+    currentKey.clear();
+    expectingKey = readingKey = readingExplanation = false;
+    unicodeEscape = 0;
+    unicodeDigitsLeft = 0;
+    highSurrogate = 0;
+    numParametersFound = 0;
+}
+
+void StreamingResponseParser::handleTextCharacter(juce::juce_wchar c, juce::String& text)
+{
+    if( c == '`' )
+    {
+        // three in a row open the fence, so hold them back until we know
+        if( ++pendingBackticks == 3 )
+        {
+            pendingBackticks = 0;
+            state = State::FenceInfo;
+        }
+
+        return;
+    }
+
+    text << juce::String::repeatedString("`", pendingBackticks);
+    pendingBackticks = 0;
+    text << juce::String::charToString(c);
+}
+
+void StreamingResponseParser::handleJsonCharacter(juce::juce_wchar c, juce::String& text)
+{
+    if( objectDepth >= 0 )
+        currentObject += c;
+
+    if( inString )
+    {
+        if( readingExplanation )
+        {
+            handleExplanationCharacter(c, text);
+            return;
+        }
+
+        if( escaped )
+            escaped = false;
+        else if( c == '\\' )
+            escaped = true;
+        else if( c == '"' )
+        {
+            inString = false;
+
+            if( readingKey )
+                readingKey = expectingKey = false;
+        }
+
+        if( readingKey && inString && ! escaped )
+            currentKey += c;
+
+        return;
+    }
+
+    if( c != '`' )
+        pendingBackticks = 0;
+
+    const bool inTopLevelObject = containers.size() == 1 && containers.back() == '{';
+
+    switch( c )
+    {
+        case '"':
+            inString = true;
+
+            if( inTopLevelObject && expectingKey )
+            {
+                readingKey = true;
+                currentKey.clear();
+            }
+            else if( inTopLevelObject && currentKey == "explanation" )
+            {
+                readingExplanation = true;
+            }
+            break;
+        case ',':
+            if( inTopLevelObject )
+                expectingKey = true;
+            break;
+        case '{':
+            // an object straight inside an array is one parameter
+            if( objectDepth < 0 && ! containers.empty() && containers.back() == '[' )
+            {
+                objectDepth = (int)containers.size();
+                currentObject.clear();
+                currentObject.preallocateBytes(128);
+                currentObject += c;
+            }
+
+            containers.push_back(c);
+
+            if( containers.size() == 1 )
+                expectingKey = true;
+            break;
+        case '[':
+            containers.push_back(c);
+            break;
+        case '}':
+        case ']':
+            if( ! containers.empty() )
+                containers.pop_back();
+
+            if( c == '}' && objectDepth == (int)containers.size() )
+            {
+                ReplyParameter parameter;
+                const bool isParameter = ReplyParameter::parse(currentObject.getCharPointer(), parameter) && parameter.id.isNotEmpty();
+
+                objectDepth = -1;
+                currentObject.clear();
+
+                if( isParameter )
+                {
+                    ++numParametersFound;
+
+                    if( onParameter )
+                        onParameter(parameter);
+                }
+            }
+
+            // the end of a bare JSON reply, anything after it is text
+            if( bareJson && containers.empty() )
+            {
+                bareJson = false;
+                state = State::Text;
+            }
+            break;
+        case '`':
+            // the closing fence, once the JSON is complete
+            if( ! bareJson && containers.empty() && ++pendingBackticks == 3 )
+            {
+                pendingBackticks = 0;
+                state = State::Text;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void StreamingResponseParser::handleExplanationCharacter(juce::juce_wchar c, juce::String& text)
+{
+    if( unicodeDigitsLeft > 0 )
+    {
+        const auto value = juce::CharacterFunctions::getHexDigitValue(c);
+
+        if( value >= 0 )
+        {
+            unicodeEscape = unicodeEscape * 16 + (juce::juce_wchar)value;
+
+            if( --unicodeDigitsLeft == 0 )
+                addEscapedCharacter(unicodeEscape, text);
+
+            return;
+        }
+
+        // a broken escape stands for one unknown character, and whatever cut it short still counts
+        unicodeDigitsLeft = 0;
+        addEscapedCharacter(replacementCharacter, text);
+    }
+
+    if( escaped )
+    {
+        escaped = false;
+
+        if( c == 'u' )
+        {
+            unicodeEscape = 0;
+            unicodeDigitsLeft = 4;
+            return;
+        }
+
+        addEscapedCharacter(getEscapedCharacter(c), text);
+        return;
+    }
+
+    // the first half of a surrogate pair has to be followed straight away by the second
+    if( c != '\\' && highSurrogate != 0 )
+    {
+        text += replacementCharacter;
+        highSurrogate = 0;
+    }
+
+    if( c == '\\' )
+        escaped = true;
+    else if( c == '"' )
+        inString = readingExplanation = false;
+    else
+        text += c;
+}
+
+void StreamingResponseParser::addEscapedCharacter(juce::juce_wchar c, juce::String& text)
+{
+    // a character outside the BMP arrives as two escapes, so the first half waits for the second
+    if( isLowSurrogate(c) && highSurrogate != 0 )
+    {
+        text += combineSurrogates(highSurrogate, c);
+        highSurrogate = 0;
+        return;
+    }
+
+    if( highSurrogate != 0 )
+    {
+        text += replacementCharacter;
+        highSurrogate = 0;
+    }
+
+    if( isHighSurrogate(c) )
+        highSurrogate = c;
+    else
+        text += isLowSurrogate(c) ? replacementCharacter : c;
+}
+
+void StreamingResponseParser::flushText(juce::String& text)
+{
+    if( text.isNotEmpty() && onText )
+        onText(text);
+
+    text.clear();
+}
@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    StreamingResponseParser.h
+    Created: 18 Oct 2026
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <functional>
+#include <vector>
+
+/**
+ One parameter object from a reply, e.g. {"id":"pf","v":750}, read without building a var tree.
+ The value may also be called "current" (the older format) or "value".
+ */
+struct ReplyParameter
+{
+    enum class Type
+    {
+        missing,
+        number,     // numbers and true/false
+        text,
+        other       // null, or an object or array where a value should be
+    };
+
+    juce::String id;
+    Type type = Type::missing;
+    double number = 0;
+    juce::String text;
+
+    /** reads a flat JSON object, false if it isn't one */
+    static bool parse(juce::String::CharPointerType json, ReplyParameter& result);
+
+    static ReplyParameter fromVar(const juce::var& object);
+};
+
+/**
+ Splits an assistant reply into its explanation text and its parameter objects while the
+ reply is still arriving. It can be fed pieces of any size, down to single characters.
+
+ Everything outside a ``` fence is text and is handed on as it comes. Inside the fence
+ the JSON is tracked one character at a time, and each object that sits directly in an
+ array (one entry of "set") is read and handed on as soon as its closing brace arrives.
+ Whatever follows the fence is text again.
+
+ A reply that is nothing but a JSON object, which is what a structured output request gets
+ back, is tracked the same way without a fence, and the string in its top level
+ "explanation" field is handed on as text while it arrives.
+
+ Nothing here touches the network, so the parser can be driven by a recorded or mock stream.
+ */
+struct StreamingResponseParser
+{
+    std::function<void(const juce::String& text)> onText;
+    std::function<void(const ReplyParameter& parameter)> onParameter;
+
+    void feed(const juce::String& piece);
+
+    /** flushes anything held back at the end of the reply, e.g. a lone backtick */
+    void finish();
+
+    void reset();
+
+    int getNumParametersFound() const { return numParametersFound; }
+private:
+    enum class State
+    {
+        Start,          // nothing but whitespace so far
+        Text,
+        FenceInfo,      // the rest of the line opening the fence, e.g. "json"
+        Json
+    };
+
+    State state = State::Start;
+    bool bareJson = false;
+
+    // backticks that may turn out to be a fence
+    int pendingBackticks = 0;
+
+    // JSON tracking: the open containers, and where we are in a string
+    std::vector<juce::juce_wchar> containers;
+    bool inString = false, escaped = false;
+
+    // the parameter object being collected, and the container depth it started at
+    juce::String currentObject;
+    int objectDepth = -1;
+
+    // keys of the top level object, and whether the string being read is the explanation
+    juce::String currentKey;
+    bool expectingKey = false, readingKey = false, readingExplanation = false;
+    juce::juce_wchar unicodeEscape = 0, highSurrogate = 0;
+    int unicodeDigitsLeft = 0;
+
+    int numParametersFound = 0;
+
+    void handleTextCharacter(juce::juce_wchar c, juce::String& text);
+    void handleJsonCharacter(juce::juce_wchar c, juce::String& text);
+    void handleExplanationCharacter(juce::juce_wchar c, juce::String& text);
+    void addEscapedCharacter(juce::juce_wchar c, juce::String& text);
+    void flushText(juce::String& text);
+};